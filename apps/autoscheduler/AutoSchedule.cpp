@@ -41,6 +41,9 @@
     *** DEPRECATED *** use the 'schedule' output from Generator instead
     Write out a human-and-machine readable block of scheduling source code for the selected schedule into this file.
 
+  HL_SCHEDULE_CACHE_DIR
+  If set, search results are cached in this (existing) directory, keyed on a hash of the algorithm, its estimates, the target, the machine params, the search settings, and the cost model weights. On a hit, the search is skipped and the cached schedule is rebuilt and applied instead. Each entry is a .schedule file in the format written by HL_SCHEDULE_FILE, plus a comment recording the path taken through the search tree. Searches that are deliberately random (random weights, or random dropout without HL_SEED) are not cached.
+
   HL_RANDOM_DROPOUT
   percent chance of accepting each state in the beam. Normalized by the number of decisions made, so 5 would be there's a 5 percent chance of never rejecting any states.
 
@@ -59,14 +62,21 @@
   value of HL_DEBUG_CODEGEN, if any).
 
   HL_AUTOSCHEDULE_MEMORY_LIMIT
-  If set, only consider schedules that allocate at most this much memory (measured in bytes).
+  If set, only consider schedules that allocate at most this much memory (measured in bytes) at once. The peak is estimated from the lifetimes of the realizations, storage folding, and the number of parallel tasks, and includes stack allocations. The estimate for the chosen schedule is written at the top of its schedule source.
+
+  HL_AUTOSCHEDULE_NUM_THREADS
+  Number of threads used to generate and featurize the children of the states in the beam. Defaults to the number of cores, which is also used if the value isn't a positive integer. Set it to 1 to expand states serially. The schedule found for a given HL_SEED does not depend on this.
 
   TODO: expose these settings by adding some means to pass args to
   generator plugins instead of environment vars.
 */
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <cstdlib>
 #include <fstream>
+#include <future>
+#include <iomanip>
 #include <iostream>
 #include <queue>
 #include <random>
@@ -153,9 +163,10 @@ uint32_t get_dropout_threshold() {
 
 // Decide whether or not to drop a beam search state. Used for
 // randomly exploring the search tree for autotuning and to generate
-// training data.
-bool random_dropout(std::mt19937 &rng, size_t num_decisions) {
-    static double random_dropout_threshold = get_dropout_threshold();
+// training data. The threshold is read from the environment once per
+// pass rather than cached for the life of the process, so that a single
+// process can autoschedule with several different settings.
+bool random_dropout(std::mt19937 &rng, uint32_t random_dropout_threshold, size_t num_decisions) {
     if (random_dropout_threshold >= 100) return false;
 
     // The random dropout threshold is the chance that we operate
@@ -178,13 +189,18 @@ struct State {
     int num_decisions_made = 0;
     bool penalized = false;
 
+    // The position of this state among the children its parent
+    // generated. Used to record and replay the path taken through
+    // the search tree.
+    int child_index = 0;
+
     State() = default;
     State(const State &) = delete;
     State(State &&) = delete;
     void operator=(const State &) = delete;
     void operator=(State &&) = delete;
 
-    static int cost_calculations;
+    static std::atomic<int> cost_calculations;
 
     uint64_t structural_hash(int depth) const {
         uint64_t h = num_decisions_made;
@@ -366,20 +382,12 @@ struct State {
             return false;
         }
 
-        // Apply the hard limit on memory use
-        if (memory_limit >= 0) {
-            int64_t mem_used = (int64_t)features.begin().value().working_set_at_root;
-            for (auto it = features.begin(); it != features.end(); it++) {
-                if (it.key()->node->is_output ||
-                    it.key()->node->is_input) {
-                    // Not allocated by this pipeline
-                    mem_used -= it.value().bytes_at_production;
-                }
-            }
-            if (mem_used > memory_limit) {
-                cost = 1e50;
-                return false;
-            }
+        // Apply the hard limit on memory use. Scheduling more Funcs
+        // only adds allocations, so this also prunes partial schedules
+        // that can't end up under the limit.
+        if (memory_limit >= 0 && root->peak_memory(params, features).total() > memory_limit) {
+            cost = 1e50;
+            return false;
         }
 
         // Tell the cost model about this state. It won't actually
@@ -410,9 +418,16 @@ struct State {
                            const MachineParams &params,
                            CostModel *cost_model,
                            int64_t memory_limit,
-                           std::function<void(IntrusivePtr<State> &&)> &accept_child) const {
+                           std::function<void(IntrusivePtr<State> &&)> &accept) const {
         internal_assert(root.defined() && root->is_root());
 
+        int num_accepted = 0;
+        std::function<void(IntrusivePtr<State> &&)> accept_child =
+            [&](IntrusivePtr<State> &&s) {
+                s->child_index = num_accepted++;
+                accept(std::move(s));
+            };
+
         if (num_decisions_made == 2 * (int)dag.nodes.size()) {
             return;
         }
@@ -725,6 +740,17 @@ struct State {
         }
     }
 
+    // The index of each state among its parent's children, from the
+    // initial state down to this one.
+    vector<int> decisions() const {
+        vector<int> result;
+        for (const State *s = this; s->parent.defined(); s = s->parent.get()) {
+            result.push_back(s->child_index);
+        }
+        std::reverse(result.begin(), result.end());
+        return result;
+    }
+
     void dump() const {
         aslog(0) << "State with cost " << cost << ":\n";
         root->dump("", nullptr);
@@ -733,6 +759,13 @@ struct State {
 
     string schedule_source;
 
+    // Estimate the peak memory the pipeline allocates with this schedule.
+    LoopNest::MemoryUse peak_memory(const FunctionDAG &dag, const MachineParams &params) {
+        StageMap<ScheduleFeatures> features;
+        compute_featurization(dag, params, &features);
+        return root->peak_memory(params, features);
+    }
+
     // Apply the schedule represented by this state to a Halide
     // Pipeline. Also generate source code for the schedule for the
     // user to copy-paste to freeze this schedule as permanent artifact.
@@ -869,8 +902,12 @@ struct State {
                 << p.second->schedule_source.str()
                 << ";\n";
         }
+        // Note the estimated peak memory use at the top of the schedule.
+        LoopNest::MemoryUse peak = peak_memory(dag, params);
+        schedule_source = "// Estimated peak memory use: " + std::to_string(peak.heap) +
+                          " bytes of heap, " + std::to_string(peak.stack) + " bytes of stack\n" +
+                          src.str();
         // Sanitize the names of things to make them legal source code.
-        schedule_source = src.str();
         bool in_quotes = false;
         for (auto &c : schedule_source) {
             in_quotes ^= (c == '"');
@@ -880,7 +917,7 @@ struct State {
 };
 
 // Keep track of how many times we evaluated a state.
-int State::cost_calculations = 0;
+std::atomic<int> State::cost_calculations{0};
 
 // A priority queue of states, sorted according to increasing
 // cost. Never shrinks, to avoid reallocations.
@@ -947,6 +984,68 @@ public:
     }
 };
 
+// Records the children generated from a state, and the schedules
+// they enqueue on the cost model, so that states can be expanded on
+// worker threads and the results replayed on the main thread in
+// exactly the order a serial expansion would have produced them.
+class DeferredExpansion : public CostModel {
+    struct Event {
+        // The accepted child, or undefined if this event enqueues a
+        // schedule on the cost model.
+        IntrusivePtr<State> child;
+        StageMapOfScheduleFeatures features;
+        double *cost_ptr = nullptr;
+    };
+    vector<Event> events;
+
+public:
+    DeferredExpansion() = default;
+    DeferredExpansion(const DeferredExpansion &) = delete;
+    void operator=(const DeferredExpansion &) = delete;
+
+    std::function<void(IntrusivePtr<State> &&)> accept_child =
+        [this](IntrusivePtr<State> &&s) {
+            events.emplace_back();
+            events.back().child = std::move(s);
+        };
+
+    void set_pipeline_features(const FunctionDAG &dag,
+                               const MachineParams &params) override {
+        internal_error << "DeferredExpansion is not configured directly\n";
+    }
+
+    void enqueue(const FunctionDAG &dag,
+                 const StageMapOfScheduleFeatures &schedule_feats,
+                 double *cost_ptr) override {
+        events.emplace_back();
+        events.back().features = schedule_feats;
+        events.back().cost_ptr = cost_ptr;
+    }
+
+    void evaluate_costs() override {
+        internal_error << "DeferredExpansion can't evaluate costs\n";
+    }
+
+    void reset() override {
+        events.clear();
+    }
+
+    // Pass everything recorded on to the real cost model and the
+    // beam, in order.
+    void replay(const FunctionDAG &dag,
+                CostModel *cost_model,
+                std::function<void(IntrusivePtr<State> &&)> &accept) {
+        for (auto &e : events) {
+            if (e.child.defined()) {
+                accept(std::move(e.child));
+            } else {
+                cost_model->enqueue(dag, e.features, e.cost_ptr);
+            }
+        }
+        events.clear();
+    }
+};
+
 // Configure a cost model to process a specific pipeline.
 void configure_pipeline_features(const FunctionDAG &dag,
                                  const MachineParams &params,
@@ -966,12 +1065,15 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                                           int pass_idx,
                                           int num_passes,
                                           ProgressBar &tick,
-                                          std::unordered_set<uint64_t> &permitted_hashes) {
+                                          std::unordered_set<uint64_t> &permitted_hashes,
+                                          ThreadPool<void> *thread_pool) {
 
     if (cost_model) {
         configure_pipeline_features(dag, params, cost_model);
     }
 
+    const uint32_t random_dropout_threshold = get_dropout_threshold();
+
     StateQueue q, pending;
 
     // The initial state, with no decisions made
@@ -1025,7 +1127,8 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                                              pass_idx,
                                              num_passes,
                                              tick,
-                                             permitted_hashes);
+                                             permitted_hashes,
+                                             thread_pool);
             } else {
                 internal_error << "Ran out of legal states with beam size " << beam_size << "\n";
             }
@@ -1035,6 +1138,7 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
             aslog(0) << "Warning: Huge number of states generated (" << pending.size() << ").\n";
         }
 
+        vector<IntrusivePtr<State>> to_expand;
         expanded = 0;
         while (expanded < beam_size && !pending.empty()) {
 
@@ -1078,7 +1182,7 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
             }
 
             // Random dropout
-            if (pending.size() > 1 && random_dropout(rng, dag.nodes.size() * 2)) {
+            if (pending.size() > 1 && random_dropout(rng, random_dropout_threshold, dag.nodes.size() * 2)) {
                 continue;
             }
 
@@ -1111,13 +1215,40 @@ IntrusivePtr<State> optimal_schedule_pass(FunctionDAG &dag,
                 return best;
             }
 
-            state->generate_children(dag, params, cost_model, memory_limit, enqueue_new_children);
+            if (thread_pool) {
+                to_expand.emplace_back(std::move(state));
+            } else {
+                state->generate_children(dag, params, cost_model, memory_limit, enqueue_new_children);
+            }
             expanded++;
         }
 
         // Drop the other states unconsidered.
         pending.clear();
 
+        if (!to_expand.empty()) {
+            // Generate and featurize the children of each selected
+            // state on the thread pool. Each state's results are
+            // handed to the cost model and the beam as soon as it
+            // and all the states before it are done, so the work
+            // overlaps, but the order (and hence the result for a
+            // given seed) is the same as expanding serially.
+            vector<DeferredExpansion> expansions(to_expand.size());
+            vector<std::future<void>> done;
+            for (size_t j = 0; j < to_expand.size(); j++) {
+                done.emplace_back(thread_pool->async([&, j]() {
+                    to_expand[j]->generate_children(dag, params, &expansions[j], memory_limit,
+                                                    expansions[j].accept_child);
+                }));
+            }
+            expanded = 0;
+            for (size_t j = 0; j < to_expand.size(); j++) {
+                done[j].get();
+                expansions[j].replay(dag, cost_model, enqueue_new_children);
+                expanded++;
+            }
+        }
+
         if (cost_model) {
             // Now evaluate all the costs and re-sort them in the priority queue
             cost_model->evaluate_costs();
@@ -1164,6 +1295,23 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
 
     IntrusivePtr<State> best;
 
+    std::unique_ptr<ThreadPool<void>> thread_pool;
+    size_t num_threads = ThreadPool<void>::num_processors_online();
+    string num_threads_str = get_env_variable("HL_AUTOSCHEDULE_NUM_THREADS");
+    if (!num_threads_str.empty()) {
+        char *end = nullptr;
+        long n = std::strtol(num_threads_str.c_str(), &end, 10);
+        if (*end == '\0' && n > 0) {
+            num_threads = (size_t)n;
+        } else {
+            aslog(0) << "Ignoring invalid HL_AUTOSCHEDULE_NUM_THREADS=" << num_threads_str
+                     << ", using " << num_threads << " threads\n";
+        }
+    }
+    if (num_threads > 1) {
+        thread_pool.reset(new ThreadPool<void>(num_threads));
+    }
+
     std::unordered_set<uint64_t> permitted_hashes;
 
     // If the beam size is one, it's pointless doing multiple passes.
@@ -1187,7 +1335,8 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
 
         auto pass = optimal_schedule_pass(dag, outputs, params, cost_model,
                                           rng, beam_size, memory_limit,
-                                          i, num_passes, tick, permitted_hashes);
+                                          i, num_passes, tick, permitted_hashes,
+                                          thread_pool.get());
 
         tick.clear();
 
@@ -1210,6 +1359,132 @@ IntrusivePtr<State> optimal_schedule(FunctionDAG &dag,
     return best;
 }
 
+// Rebuild the state reached by following a sequence of decisions, as
+// returned by State::decisions(), from the initial state. Returns an
+// undefined pointer if the decisions don't lead to a complete
+// schedule for this dag.
+IntrusivePtr<State> replay_decisions(const FunctionDAG &dag,
+                                     const MachineParams &params,
+                                     int64_t memory_limit,
+                                     const vector<int> &decisions) {
+    IntrusivePtr<State> state{new State};
+    state->root = new LoopNest;
+
+    // The children are still featurized as they are generated, but
+    // we don't need their costs.
+    DeferredExpansion discard;
+    for (int d : decisions) {
+        vector<IntrusivePtr<State>> children;
+        std::function<void(IntrusivePtr<State> &&)> accept =
+            [&](IntrusivePtr<State> &&s) {
+                children.emplace_back(std::move(s));
+            };
+        state->generate_children(dag, params, &discard, memory_limit, accept);
+        discard.reset();
+        if (d < 0 || d >= (int)children.size()) {
+            return IntrusivePtr<State>();
+        }
+        state = children[d];
+    }
+
+    if (state->num_decisions_made != 2 * (int)dag.nodes.size()) {
+        return IntrusivePtr<State>();
+    }
+    return state;
+}
+
+// Compute the name of the schedule cache entry for a search. The key
+// covers everything the result of the search depends on.
+string schedule_cache_key(const FunctionDAG &dag,
+                          const Target &target,
+                          const MachineParams &params,
+                          const DefaultCostModel &cost_model,
+                          size_t beam_size,
+                          int64_t memory_limit) {
+    std::ostringstream key;
+    key << "Adams2019 schedule cache v1\n"
+        << PipelineFeatures::version() << " " << ScheduleFeatures::version() << "\n"
+        << target.to_string() << "\n"
+        << params.to_string() << "\n"
+        << beam_size << " " << memory_limit << " " << may_subtile() << "\n"
+        << get_env_variable("HL_NUM_PASSES") << "\n"
+        << get_env_variable("HL_SEED") << " " << get_dropout_threshold() << "\n";
+    // The dag dump includes the estimates and the featurization of
+    // each stage.
+    dag.dump(key);
+    cost_model.save_weights(key);
+
+    // 64-bit FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for (char c : key.str()) {
+        h ^= (unsigned char)c;
+        h *= 1099511628211ULL;
+    }
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << h;
+    return name.str();
+}
+
+// Look up a search result in the schedule cache. Returns an undefined
+// pointer on a miss, or if the entry no longer describes a legal
+// schedule.
+IntrusivePtr<State> load_cached_schedule(const string &path,
+                                         const FunctionDAG &dag,
+                                         const MachineParams &params,
+                                         int64_t memory_limit) {
+    std::ifstream f(path);
+    if (!f) {
+        return IntrusivePtr<State>();
+    }
+
+    const string decisions_prefix = "// Decisions:";
+    vector<int> decisions;
+    bool found = false;
+    string line;
+    while (std::getline(f, line)) {
+        if (starts_with(line, decisions_prefix)) {
+            std::istringstream ss(line.substr(decisions_prefix.size()));
+            int d;
+            while (ss >> d) {
+                decisions.push_back(d);
+            }
+            found = true;
+            break;
+        }
+    }
+
+    IntrusivePtr<State> state;
+    if (found) {
+        state = replay_decisions(dag, params, memory_limit, decisions);
+    }
+    if (!state.defined()) {
+        aslog(0) << "Ignoring stale schedule cache entry " << path << "\n";
+    }
+    return state;
+}
+
+// Save a search result to the schedule cache.
+void save_cached_schedule(const string &path, const State &state) {
+    // Write to a temporary file and rename it into place, so that
+    // concurrent builds never see a partial entry.
+    std::random_device rd;
+    string tmp_path = path + "." + std::to_string(rd()) + ".tmp";
+    std::ofstream f(tmp_path);
+    f << "// Decisions:";
+    for (int d : state.decisions()) {
+        f << " " << d;
+    }
+    f << "\n"
+      << "// --- BEGIN machine-generated schedule\n"
+      << state.schedule_source
+      << "// --- END machine-generated schedule\n";
+    f.close();
+    if (f.fail() || std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+        aslog(0) << "Warning: Failed to write schedule cache entry " << path << "\n";
+        std::remove(tmp_path.c_str());
+    }
+}
+
 // The main entrypoint to generate a schedule for a pipeline.
 void generate_schedule(const std::vector<Function> &outputs,
                        const Target &target,
@@ -1258,17 +1533,37 @@ void generate_schedule(const std::vector<Function> &outputs,
     // Construct a cost model to use to evaluate states. Currently we
     // just have the one, but it's an abstract interface, so others
     // can be slotted in for experimentation.
-    std::unique_ptr<CostModel> cost_model = make_default_cost_model(weights_in_path, weights_out_path, randomize_weights);
+    std::unique_ptr<DefaultCostModel> cost_model = make_default_cost_model(weights_in_path, weights_out_path, randomize_weights);
     internal_assert(cost_model != nullptr);
 
     IntrusivePtr<State> optimal;
 
-    // Run beam search
-    optimal = optimal_schedule(dag, outputs, params, cost_model.get(), rng, beam_size, memory_limit);
+    // Searches that are meant to be random can't be cached.
+    string cache_dir = get_env_variable("HL_SCHEDULE_CACHE_DIR");
+    bool use_cache = (!cache_dir.empty() &&
+                      !randomize_weights &&
+                      get_env_variable("HL_CYOS") != "1" &&
+                      (!seed_str.empty() || get_dropout_threshold() >= 100));
+    string cache_path;
+    if (use_cache) {
+        cache_path = cache_dir + "/" +
+                     schedule_cache_key(dag, target, params, *cost_model, beam_size, memory_limit) +
+                     ".schedule";
+        optimal = load_cached_schedule(cache_path, dag, params, memory_limit);
+        if (optimal.defined()) {
+            aslog(0) << "Using cached schedule " << cache_path << "\n";
+        }
+    }
+    bool cache_hit = optimal.defined();
+
+    if (!cache_hit) {
+        // Run beam search
+        optimal = optimal_schedule(dag, outputs, params, cost_model.get(), rng, beam_size, memory_limit);
+    }
 
     HALIDE_TOC;
 
-    aslog(1) << "Cost evaluated this many times: " << State::cost_calculations << "\n";
+    aslog(1) << "Cost evaluated this many times: " << State::cost_calculations.load() << "\n";
 
     // Dump the schedule found
     aslog(1) << "** Optimal schedule:\n";
@@ -1276,9 +1571,17 @@ void generate_schedule(const std::vector<Function> &outputs,
     // Just to get the debugging prints to fire
     optimal->calculate_cost(dag, params, cost_model.get(), memory_limit, aslog::aslog_level() > 0);
 
+    LoopNest::MemoryUse peak = optimal->peak_memory(dag, params);
+    aslog(1) << "Estimated peak memory use: " << peak.heap << " bytes of heap, "
+             << peak.stack << " bytes of stack\n";
+
     // Apply the schedules to the pipeline
     optimal->apply_schedule(dag, params);
 
+    if (use_cache && !cache_hit) {
+        save_cached_schedule(cache_path, *optimal);
+    }
+
     // Print out the schedule
     if (aslog::aslog_level() > 0) {
         optimal->dump();
@@ -1360,16 +1663,6 @@ void find_and_apply_schedule(FunctionDAG &dag,
 }  // namespace Autoscheduler
 
 // Intrusive shared ptr helpers.
-template<>
-RefCount &ref_count<Autoscheduler::LoopNest>(const Autoscheduler::LoopNest *t) noexcept {
-    return t->ref_count;
-}
-
-template<>
-void destroy<Autoscheduler::LoopNest>(const Autoscheduler::LoopNest *t) {
-    delete t;
-}
-
 template<>
 RefCount &ref_count<Autoscheduler::State>(const Autoscheduler::State *t) noexcept {
     return t->ref_count;
@@ -367,6 +367,10 @@ void DefaultCostModel::save_weights() {
     }
 }
 
+void DefaultCostModel::save_weights(std::ostream &out) const {
+    internal_assert(weights.save(out)) << "Unable to serialize weights\n";
+}
+
 // Discard any enqueued but unevaluated schedules
 void DefaultCostModel::reset() {
     cursor = 0;
@@ -12,7 +12,7 @@ private:
     Internal::Weights weights;
     Runtime::Buffer<float> schedule_feat_queue, pipeline_feat_queue, costs;
     Runtime::Buffer<double *> cost_ptrs;
-    int cursor, num_stages, num_cores;
+    int cursor = 0, num_stages = 0, num_cores = 0;
 
     const std::string weights_in_path, weights_out_path;
     const bool randomize_weights;
@@ -59,6 +59,9 @@ public:
     // Save/Load the model weights to/from disk.
     void save_weights();
     void load_weights();
+
+    // Serialize the current weights, e.g. to fingerprint the model.
+    void save_weights(std::ostream &out) const;
 };
 
 std::unique_ptr<DefaultCostModel> make_default_cost_model(const std::string &weights_in_dir = "",
@@ -7,6 +7,7 @@
 
 #include <algorithm>
 #include <map>
+#include <mutex>
 #include <stdint.h>
 #include <string>
 #include <vector>
@@ -185,6 +186,28 @@ public:
         return result;
     }
 
+    template<typename OS>
+    void dump(OS &os, const char *prefix) const {
+        if (count() > 1) {
+            os << prefix << count() << " x\n";
+        }
+        for (size_t i = 0; i < producer_storage_dims(); i++) {
+            os << prefix << "  [";
+
+            for (size_t j = 0; j < consumer_loop_dims(); j++) {
+                const auto &c = (*this)(i, j);
+                if (!c.exists) {
+                    os << " _  ";
+                } else if (c.denominator == 1) {
+                    os << " " << c.numerator << "  ";
+                } else {
+                    os << c.numerator << "/" << c.denominator << " ";
+                }
+            }
+            os << "]\n";
+        }
+        os << "\n";
+    }
     void dump(const char *prefix) const;
 };
 
@@ -297,9 +320,13 @@ struct BoundContents {
     // We're frequently going to need to make these concrete bounds
     // arrays.  It makes things more efficient if we figure out the
     // memory layout of those data structures once ahead of time, and
-    // make each individual instance just use that. Note that this is
-    // not thread-safe.
+    // make each individual instance just use that. The memory pool is
+    // guarded by a mutex, because states are expanded on several
+    // threads at once.
     class Layout {
+        // Protects the pool, the blocks, and the live count.
+        mutable std::mutex mutex;
+
         // A memory pool of free BoundContent objects with this layout
         mutable std::vector<BoundContents *> pool;
 
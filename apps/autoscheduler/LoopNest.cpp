@@ -112,7 +112,10 @@ void LoopNest::copy_from(const LoopNest &n) {
     children = n.children;
     inlined = n.inlined;
     store_at = n.store_at;
-    bounds = n.bounds;
+    {
+        std::lock_guard<std::mutex> lock(n.bounds_mutex);
+        bounds = n.bounds;
+    }
     node = n.node;
     stage = n.stage;
     innermost = n.innermost;
@@ -937,12 +940,15 @@ void LoopNest::compute_features(const FunctionDAG &dag,
 // Get the region required of a Func at this site, from which we
 // know what region would be computed if it were scheduled here,
 // and what its loop nest would be.
-const Bound &LoopNest::get_bounds(const FunctionDAG::Node *f) const {
-    if (bounds.contains(f)) {
-        const Bound &b = bounds.get(f);
-        // Expensive validation for debugging
-        // b->validate();
-        return b;
+Bound LoopNest::get_bounds(const FunctionDAG::Node *f) const {
+    {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
+        if (bounds.contains(f)) {
+            const Bound &b = bounds.get(f);
+            // Expensive validation for debugging
+            // b->validate();
+            return b;
+        }
     }
     auto bound = f->make_bound();
 
@@ -994,7 +1000,7 @@ const Bound &LoopNest::get_bounds(const FunctionDAG::Node *f) const {
         f->loop_nest_for_region(i, &(bound->region_computed(0)), &(bound->loops(i, 0)));
     }
 
-    const Bound &b = set_bounds(f, bound);
+    Bound b = set_bounds(f, bound);
     // Validation is expensive, turn if off by default.
     // b->validate();
     return b;
@@ -1071,6 +1077,88 @@ bool LoopNest::calls(const FunctionDAG::Node *f) const {
     return false;
 }
 
+LoopNest::MemoryUse LoopNest::peak_memory(const MachineParams &params,
+                                          const StageMap<ScheduleFeatures> &features) const {
+    // Constant-sized allocations up to this size go on the stack,
+    // unless they are made at root. See can_allocation_fit_on_stack.
+    const int64_t max_stack_bytes = 16 * 1024;
+
+    struct Allocation {
+        int64_t bytes;
+        bool on_stack;
+        // The range of children that use it
+        int first, last;
+    };
+    vector<Allocation> allocations;
+    for (const auto *f : store_at) {
+        if (f->is_input || f->is_output) {
+            // Allocated by the caller
+            continue;
+        }
+        const auto &feat = features.get(&(f->stages[0]));
+        Allocation a;
+        a.bytes = (int64_t)feat.bytes_at_realization;
+        bool computed_here = false;
+        for (const auto &c : children) {
+            computed_here |= (c->node == f);
+        }
+        if (!computed_here) {
+            // Stored outside the loop it's computed in, so storage
+            // folding can shrink it to the window needed by the
+            // current production plus the one before.
+            a.bytes = std::min(a.bytes, 2 * (int64_t)feat.bytes_at_production);
+        }
+        a.on_stack = !is_root() && a.bytes <= max_stack_bytes;
+        a.first = -1;
+        a.last = -1;
+        for (int i = 0; i < (int)children.size(); i++) {
+            if (children[i]->computes(f) || children[i]->calls(f)) {
+                if (a.first < 0) {
+                    a.first = i;
+                }
+                a.last = i;
+            }
+        }
+        if (a.first < 0) {
+            a.first = 0;
+            a.last = (int)children.size() - 1;
+        }
+        allocations.push_back(a);
+    }
+
+    auto live_during = [&](int i) {
+        MemoryUse live;
+        for (const auto &a : allocations) {
+            if (i < 0 || (a.first <= i && i <= a.last)) {
+                (a.on_stack ? live.stack : live.heap) += a.bytes;
+            }
+        }
+        return live;
+    };
+
+    if (children.empty()) {
+        return live_during(-1);
+    }
+
+    MemoryUse peak;
+    for (int i = 0; i < (int)children.size(); i++) {
+        MemoryUse live = live_during(i);
+        MemoryUse inner = children[i]->peak_memory(params, features);
+        if (children[i]->parallel) {
+            int64_t tasks = 1;
+            for (int64_t s : children[i]->size) {
+                tasks *= s;
+            }
+            tasks = std::min(tasks, (int64_t)std::max(1, params.parallelism));
+            inner.heap *= tasks;
+            inner.stack *= tasks;
+        }
+        peak.heap = std::max(peak.heap, live.heap + inner.heap);
+        peak.stack = std::max(peak.stack, live.stack + inner.stack);
+    }
+    return peak;
+}
+
 // What is the maximum number of inlined calls to a Func that
 // occur within this loop. Used to prune states that would
 // generate too much code.
@@ -1272,7 +1360,10 @@ IntrusivePtr<const LoopNest> LoopNest::parallelize_in_tiles(const MachineParams
     inner->innermost = innermost;
     inner->children = children;
     inner->inlined = inlined;
-    inner->bounds = bounds;
+    {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
+        inner->bounds = bounds;
+    }
     inner->store_at = store_at;
 
     auto b = inner->get_bounds(node)->make_copy();
@@ -1436,7 +1527,10 @@ vector<IntrusivePtr<const LoopNest>> LoopNest::compute_in_tiles(const FunctionDA
             inner->innermost = innermost;
             inner->children = children;
             inner->inlined = inlined;
-            inner->bounds = bounds;
+            {
+                std::lock_guard<std::mutex> lock(bounds_mutex);
+                inner->bounds = bounds;
+            }
             inner->store_at = store_at;
 
             {
@@ -1841,5 +1935,16 @@ void LoopNest::apply(LoopLevel here,
 }
 
 }  // namespace Autoscheduler
+
+template<>
+RefCount &ref_count<Autoscheduler::LoopNest>(const Autoscheduler::LoopNest *t) noexcept {
+    return t->ref_count;
+}
+
+template<>
+void destroy<Autoscheduler::LoopNest>(const Autoscheduler::LoopNest *t) {
+    delete t;
+}
+
 }  // namespace Internal
 }  // namespace Halide
@@ -8,6 +8,7 @@
 
 #include "FunctionDAG.h"
 #include "PerfectHashMap.h"
+#include <mutex>
 #include <set>
 #include <vector>
 
@@ -50,8 +51,12 @@ struct LoopNest {
 
     // The total bounds required of any given Func over all iterations
     // of this loop. In the paper, this is represented using the
-    // little boxes to the left of the loop nest tree figures.
+    // little boxes to the left of the loop nest tree figures. Filled
+    // in lazily, and loop nests are shared between the states being
+    // expanded on different threads, so it is guarded by
+    // bounds_mutex.
     mutable NodeMap<Bound> bounds;
+    mutable std::mutex bounds_mutex;
 
     // The Func this loop nest belongs to
     const FunctionDAG::Node *node = nullptr;
@@ -134,21 +139,42 @@ struct LoopNest {
                           int64_t *working_set,
                           StageMap<ScheduleFeatures> *features) const;
 
+    // Memory allocated by the pipeline itself, split by where it lives.
+    struct MemoryUse {
+        int64_t heap = 0, stack = 0;
+        int64_t total() const {
+            return heap + stack;
+        }
+    };
+
+    // Estimate the peak memory allocated while running this loop
+    // nest, given its featurization. Realizations are live from their
+    // first to their last use among the children of the loop they are
+    // stored at, realizations stored outside the loop they are
+    // computed in are assumed to be folded down to a couple of
+    // productions, and allocations made inside a parallel loop are
+    // counted once per concurrent task.
+    MemoryUse peak_memory(const MachineParams &params,
+                          const StageMap<ScheduleFeatures> &features) const;
+
     bool is_root() const {
         // The root is the sole node without a Func associated with
         // it.
         return node == nullptr;
     }
 
-    // Set the region required of a Func at this site.
-    const Bound &set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+    // Set the region required of a Func at this site. Returns the
+    // Bound by value, because other threads may insert into the map
+    // and invalidate references to its contents.
+    Bound set_bounds(const FunctionDAG::Node *f, BoundContents *b) const {
+        std::lock_guard<std::mutex> lock(bounds_mutex);
         return bounds.emplace(f, b);
     }
 
     // Get the region required of a Func at this site, from which we
     // know what region would be computed if it were scheduled here,
     // and what its loop nest would be.
-    const Bound &get_bounds(const FunctionDAG::Node *f) const;
+    Bound get_bounds(const FunctionDAG::Node *f) const;
 
     // Recursively print a loop nest representation to stderr
     void dump(string prefix, const LoopNest *parent) const;
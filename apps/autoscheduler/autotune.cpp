@@ -0,0 +1,683 @@
+// An in-process version of autotune_loop.sh. Generates batches of random
+// schedules for a generator that is linked into this binary, JIT-compiles
+// them in parallel, benchmarks them serially, and retrains the cost model
+// on the results, all without leaving the process.
+//
+// Samples are written to the same directory layout that autotune_loop.sh
+// uses, so they can also be fed to retrain_cost_model later.
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include "Halide.h"
+#include "cmdline.h"
+#include "halide_benchmark.h"
+
+#include "DefaultCostModel.h"
+#include "NetworkSize.h"
+
+namespace {
+
+using namespace Halide;
+
+using Halide::Internal::GeneratorBase;
+using Halide::Internal::GeneratorParamsMap;
+using Halide::Internal::GeneratorRegistry;
+using std::map;
+using std::string;
+using std::vector;
+
+struct Flags {
+    string generator;
+    vector<string> generator_args_sets;
+    string target;
+    string initial_weights_path;
+    string samples_dir;
+    string machine_params;
+    int batches = 1;
+    int batch_size = 32;
+    int epochs = 0;
+    float rate = 0.0001f;
+    int num_cores = 32;
+    double benchmark_min_time = 0.1;
+
+    Flags(int argc, char **argv) {
+        cmdline::parser a;
+
+        const char *kNoDesc = "";
+
+        constexpr bool kOptional = false;
+        a.add<string>("generator");
+        a.add<string>("generator_args", '\0', "Sets of generator args, separated by spaces. Args within a set are separated by ';'", kOptional, "");
+        a.add<string>("target", '\0', kNoDesc, kOptional, "");
+        a.add<string>("initial_weights", '\0', kNoDesc, kOptional, "");
+        a.add<string>("samples");
+        a.add<string>("machine_params", '\0', kNoDesc, kOptional, "32,24000000,40");
+        a.add<int>("batches", '\0', kNoDesc, kOptional, 1);
+        a.add<int>("batch_size", '\0', kNoDesc, kOptional, 32);
+        a.add<int>("epochs", '\0', "Defaults to the batch size", kOptional, 0);
+        a.add<float>("rate", '\0', kNoDesc, kOptional, 0.0001f);
+        a.add<int>("num_cores", '\0', kNoDesc, kOptional, 32);
+        a.add<double>("benchmark_min_time", '\0', kNoDesc, kOptional, 0.1);
+
+        a.parse_check(argc, argv);  // exits if parsing fails
+
+        generator = a.get<string>("generator");
+        generator_args_sets = split(a.get<string>("generator_args"), ' ');
+        target = a.get<string>("target");
+        initial_weights_path = a.get<string>("initial_weights");
+        samples_dir = a.get<string>("samples");
+        machine_params = a.get<string>("machine_params");
+        batches = a.get<int>("batches");
+        batch_size = a.get<int>("batch_size");
+        epochs = a.get<int>("epochs");
+        rate = a.get<float>("rate");
+        num_cores = a.get<int>("num_cores");
+        benchmark_min_time = a.get<double>("benchmark_min_time");
+
+        if (generator_args_sets.empty()) {
+            generator_args_sets.emplace_back();
+        }
+        if (epochs <= 0) {
+            epochs = batch_size;
+        }
+        if (batches <= 0 || batch_size <= 0) {
+            std::cerr << "--batches and --batch_size must be > 0.\n";
+            std::cerr << a.usage();
+            exit(1);
+        }
+    }
+
+    static vector<string> split(const string &s, char delim) {
+        vector<string> v;
+        std::istringstream in(s);
+        string item;
+        while (std::getline(in, item, delim)) {
+            if (!item.empty()) {
+                v.push_back(item);
+            }
+        }
+        return v;
+    }
+};
+
+void set_env_variable(const string &name, const string &value) {
+#ifdef _WIN32
+    _putenv_s(name.c_str(), value.c_str());
+#else
+    setenv(name.c_str(), value.c_str(), 1);
+#endif
+}
+
+void make_dir(const string &path) {
+#ifdef _WIN32
+    _mkdir(path.c_str());
+#else
+    mkdir(path.c_str(), 0755);
+#endif
+}
+
+void copy_file(const string &src_path, const string &dst_path) {
+    std::ifstream src(src_path, std::ios::binary);
+    std::ofstream dst(dst_path, std::ios::binary);
+    dst << src.rdbuf();
+    if (src.fail() || dst.fail()) {
+        std::cerr << "Unable to copy " << src_path << " to " << dst_path << "\n";
+        exit(1);
+    }
+}
+
+// One random schedule for a pipeline, and everything needed to run it.
+struct Candidate {
+    int32_t pipeline_id, schedule_id;
+    string dir, name;
+    std::unique_ptr<GeneratorBase> generator;
+    Pipeline pipeline;
+    AutoSchedulerResults results;
+    // The shapes of the output buffers, in the order the pipeline
+    // takes them.
+    vector<vector<halide_dimension_t>> output_shapes;
+    // The lowered pipeline, until it is compiled.
+    std::unique_ptr<Module> lowered;
+    Internal::JITModule module;
+    vector<Internal::LoweredArgument> args;
+    bool compiled = false;
+};
+
+// Read a constant from a bound, or return false if it isn't one.
+bool const_bound(const Expr &e, int *result) {
+    if (!e.defined()) {
+        return false;
+    }
+    const int64_t *i = Internal::as_const_int(Internal::simplify(cast<int>(e)));
+    if (!i) {
+        return false;
+    }
+    *result = (int)*i;
+    return true;
+}
+
+// Size each output using its estimates, falling back to its bounds.
+bool get_output_shapes(Candidate *c) {
+    for (Func out : c->pipeline.outputs()) {
+        const Internal::FuncSchedule &sched = out.function().schedule();
+        vector<halide_dimension_t> shape;
+        int stride = 1;
+        for (const Var &v : out.args()) {
+            int min = 0, extent = 0;
+            bool found = false;
+            for (const auto *bounds : {&sched.estimates(), &sched.bounds()}) {
+                for (const Internal::Bound &b : *bounds) {
+                    if (b.var == v.name() &&
+                        const_bound(b.min, &min) &&
+                        const_bound(b.extent, &extent)) {
+                        found = true;
+                        break;
+                    }
+                }
+                if (found) {
+                    break;
+                }
+            }
+            if (!found) {
+                std::cerr << "Output " << out.name() << " has no estimate for " << v.name() << "\n";
+                return false;
+            }
+            shape.emplace_back(min, extent, stride);
+            stride *= extent;
+        }
+        for (size_t i = 0; i < out.output_types().size(); i++) {
+            c->output_shapes.push_back(shape);
+        }
+    }
+    return true;
+}
+
+// Build and autoschedule a fresh instance of the generator with the
+// given search settings. The autoscheduler reads its settings from the
+// environment, so this must not run concurrently with anything else that
+// does.
+bool build(const Flags &flags, const Target &target,
+           const GeneratorParamsMap &generator_args,
+           const string &weights_path, int beam_size, int dropout,
+           Candidate *c) {
+    set_env_variable("HL_SEED", std::to_string(c->schedule_id));
+    set_env_variable("HL_WEIGHTS_DIR", weights_path);
+    set_env_variable("HL_RANDOM_DROPOUT", std::to_string(dropout));
+    set_env_variable("HL_BEAM_SIZE", std::to_string(beam_size));
+
+    const GeneratorContext context(target.with_feature(Target::JIT), true, MachineParams(flags.machine_params));
+    c->generator = GeneratorRegistry::create(flags.generator, context);
+    c->generator->set_generator_param_values(generator_args);
+    c->lowered.reset(new Module(c->generator->build_module(c->name, LinkageType::External)));
+    c->pipeline = c->generator->get_pipeline();
+    if (!get_output_shapes(c)) {
+        return false;
+    }
+    c->results = *c->lowered->get_auto_scheduler_results();
+    return !c->results.featurization.empty();
+}
+
+// Generate code for a candidate. Safe to call from several threads at once.
+void compile(Candidate *c) {
+    Internal::LoweredFunc f = c->lowered->get_function_by_name(c->name);
+    c->args = f.args;
+    c->module = Internal::JITModule(*c->lowered, f);
+    c->lowered.reset();
+    c->compiled = true;
+}
+
+template<typename T>
+void store(halide_scalar_value_t *v, T x) {
+    memcpy(&v->u, &x, sizeof(x));
+}
+
+// Pick a value for a scalar input: its estimate if it has one, then its
+// default, then zero.
+halide_scalar_value_t scalar_value(const Argument &arg) {
+    halide_scalar_value_t v;
+    v.u.u64 = 0;
+    Expr e = arg.argument_estimates.scalar_estimate;
+    if (!e.defined()) {
+        e = arg.argument_estimates.scalar_def;
+    }
+    if (!e.defined() || arg.type.is_handle()) {
+        return v;
+    }
+    e = Internal::simplify(cast(arg.type, e));
+    const Type &t = arg.type;
+    if (const double *f = Internal::as_const_float(e)) {
+        if (t.bits() == 32) {
+            store<float>(&v, (float)*f);
+        } else if (t.bits() == 64) {
+            store<double>(&v, *f);
+        }
+    } else if (const int64_t *i = Internal::as_const_int(e)) {
+        switch (t.bits()) {
+        case 8:
+            store<int8_t>(&v, (int8_t)*i);
+            break;
+        case 16:
+            store<int16_t>(&v, (int16_t)*i);
+            break;
+        case 32:
+            store<int32_t>(&v, (int32_t)*i);
+            break;
+        default:
+            store<int64_t>(&v, *i);
+        }
+    } else if (const uint64_t *u = Internal::as_const_uint(e)) {
+        switch (t.bits()) {
+        case 1:
+            store<bool>(&v, *u != 0);
+            break;
+        case 8:
+            store<uint8_t>(&v, (uint8_t)*u);
+            break;
+        case 16:
+            store<uint16_t>(&v, (uint16_t)*u);
+            break;
+        case 32:
+            store<uint32_t>(&v, (uint32_t)*u);
+            break;
+        default:
+            store<uint64_t>(&v, *u);
+        }
+    }
+    return v;
+}
+
+// Fill a densely-allocated buffer with random data. Floats are in [0, 1).
+void fill_random(Runtime::Buffer<> &b, std::mt19937 &rng) {
+    const halide_type_t t = b.type();
+    if (t.code == halide_type_float && t.bits == 32) {
+        std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+        float *p = (float *)b.data();
+        for (size_t i = 0; i < b.number_of_elements(); i++) {
+            p[i] = dist(rng);
+        }
+    } else if (t.code == halide_type_float && t.bits == 64) {
+        std::uniform_real_distribution<double> dist(0.0, 1.0);
+        double *p = (double *)b.data();
+        for (size_t i = 0; i < b.number_of_elements(); i++) {
+            p[i] = dist(rng);
+        }
+    } else if (t.code == halide_type_float) {
+        memset(b.data(), 0, b.size_in_bytes());
+    } else {
+        const uint8_t mask = (t.bits == 1) ? 1 : 0xff;
+        uint8_t *p = (uint8_t *)b.data();
+        for (size_t i = 0; i < b.size_in_bytes(); i++) {
+            p[i] = (uint8_t)rng() & mask;
+        }
+    }
+}
+
+// Allocate and fill the inputs and outputs of a compiled candidate, and
+// return its runtime in seconds, or a negative number if it failed.
+double benchmark(const Flags &flags, Candidate *c, std::mt19937 &rng) {
+    const size_t n = c->args.size();
+    vector<Runtime::Buffer<>> buffers(n);
+    vector<halide_scalar_value_t> scalars(n);
+    vector<const void *> argv(n, nullptr);
+    size_t output_idx = 0;
+    for (size_t i = 0; i < n; i++) {
+        const Internal::LoweredArgument &arg = c->args[i];
+        if (arg.is_scalar()) {
+            scalars[i] = scalar_value(arg);
+            argv[i] = &scalars[i];
+        } else if (arg.is_input()) {
+            // Leave the host pointer null for now, so that the first
+            // call is a bounds query for the inputs.
+            vector<halide_dimension_t> shape(arg.dimensions);
+            buffers[i] = Runtime::Buffer<>(arg.type, nullptr, arg.dimensions, shape.data());
+            argv[i] = buffers[i].raw_buffer();
+        } else {
+            internal_assert(output_idx < c->output_shapes.size());
+            const vector<halide_dimension_t> &shape = c->output_shapes[output_idx++];
+            vector<int> mins, extents;
+            for (const auto &d : shape) {
+                mins.push_back(d.min);
+                extents.push_back(d.extent);
+            }
+            buffers[i] = Runtime::Buffer<>(arg.type, extents);
+            buffers[i].set_min(mins);
+            argv[i] = buffers[i].raw_buffer();
+        }
+    }
+
+    auto argv_fn = c->module.argv_function();
+    if (argv_fn(argv.data()) != 0) {
+        return -1;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        const Internal::LoweredArgument &arg = c->args[i];
+        if (arg.is_scalar() || !arg.is_input()) {
+            continue;
+        }
+        const halide_buffer_t *query = buffers[i].raw_buffer();
+        vector<int> mins, extents;
+        for (int d = 0; d < query->dimensions; d++) {
+            mins.push_back(query->dim[d].min);
+            extents.push_back(query->dim[d].extent);
+        }
+        Runtime::Buffer<> b(arg.type, extents);
+        b.set_min(mins);
+        fill_random(b, rng);
+        buffers[i] = std::move(b);
+        argv[i] = buffers[i].raw_buffer();
+    }
+
+    // Run it once outside the timing loop to catch failures and warm up.
+    if (argv_fn(argv.data()) != 0) {
+        return -1;
+    }
+    Tools::BenchmarkConfig config;
+    config.min_time = flags.benchmark_min_time;
+    config.max_time = flags.benchmark_min_time * 4;
+    int result = 0;
+    Tools::BenchmarkResult r = Tools::benchmark([&]() { result |= argv_fn(argv.data()); }, config);
+    return result ? -1 : r.wall_time;
+}
+
+// The samples for one pipeline, deduplicated by schedule, in the form
+// the cost model trains on.
+struct PipelineSamples {
+    int num_stages = 0;
+    Runtime::Buffer<float> pipeline_features;
+    struct Schedule {
+        Runtime::Buffer<float> features;
+        float runtime;  // in msec
+        double prediction;
+    };
+    map<uint64_t, Schedule> schedules;
+};
+
+uint64_t hash_floats(uint64_t h, const float *begin, const float *end) {
+    while (begin != end) {
+        uint32_t bits;
+        memcpy(&bits, begin, sizeof(bits));
+        // From boost
+        h ^= (bits + 0x9e3779b9 + (h << 6) + (h >> 2));
+        begin++;
+    }
+    return h;
+}
+
+// Add a featurization and its runtime to the training set. See
+// retrain_cost_model.cpp for the layout.
+void add_sample(const vector<uint8_t> &featurization, float runtime_ms, PipelineSamples *ps) {
+    const size_t features_per_stage = head2_w + (head1_w + 1) * head1_h;
+    const size_t num_floats = featurization.size() / sizeof(float);
+    if (num_floats == 0 || num_floats % features_per_stage != 0) {
+        std::cerr << "Malformed featurization of " << featurization.size() << " bytes\n";
+        return;
+    }
+    const size_t num_stages = num_floats / features_per_stage;
+    vector<float> f(num_floats);
+    memcpy(f.data(), featurization.data(), num_floats * sizeof(float));
+
+    if (ps->num_stages == 0) {
+        ps->num_stages = (int)num_stages;
+        ps->pipeline_features = Runtime::Buffer<float>(head1_w, head1_h, num_stages);
+        for (size_t i = 0; i < num_stages; i++) {
+            for (int x = 0; x < head1_w; x++) {
+                for (int y = 0; y < head1_h; y++) {
+                    ps->pipeline_features(x, y, i) = f[i * features_per_stage + (x + 1) * 7 + y + head2_w];
+                }
+            }
+        }
+    } else if (ps->num_stages != (int)num_stages) {
+        std::cerr << "Featurization has " << num_stages << " stages instead of " << ps->num_stages << "\n";
+        return;
+    }
+
+    Runtime::Buffer<float> features(head2_w, num_stages);
+    uint64_t schedule_hash = 0;
+    for (size_t i = 0; i < num_stages; i++) {
+        const float *stage = &f[i * features_per_stage];
+        for (int x = 0; x < head2_w; x++) {
+            if (stage[x] < 0 || stage[x] > 1e14 || std::isnan(stage[x])) {
+                std::cerr << "Negative or implausibly large schedule feature: " << i << " " << x << " " << stage[x] << "\n";
+                return;
+            }
+            features(x, i) = stage[x];
+        }
+        schedule_hash = hash_floats(schedule_hash, stage, stage + head2_w);
+    }
+
+    auto it = ps->schedules.find(schedule_hash);
+    if (it == ps->schedules.end()) {
+        ps->schedules.emplace(schedule_hash, PipelineSamples::Schedule{features, runtime_ms, 0.0});
+    } else {
+        it->second.runtime = std::min(it->second.runtime, runtime_ms);
+    }
+}
+
+void write_sample(const Candidate &c, float runtime_ms) {
+    std::ofstream sample(c.dir + "/" + c.name + ".sample", std::ios::binary);
+    sample.write((const char *)c.results.featurization.data(), c.results.featurization.size());
+    sample.write((const char *)&runtime_ms, sizeof(runtime_ms));
+    sample.write((const char *)&c.pipeline_id, sizeof(c.pipeline_id));
+    sample.write((const char *)&c.schedule_id, sizeof(c.schedule_id));
+
+    std::ofstream schedule(c.dir + "/" + c.name + ".schedule.h");
+    schedule << c.results.schedule_source;
+}
+
+// Retrain the cost model on everything benchmarked so far.
+void retrain(const Flags &flags, map<int, PipelineSamples> &samples, DefaultCostModel *cost_model) {
+    for (int e = 0; e < flags.epochs; e++) {
+        float loss_sum = 0;
+        int loss_count = 0;
+        for (auto &p : samples) {
+            PipelineSamples &ps = p.second;
+            if (ps.schedules.size() < 8) {
+                continue;
+            }
+            cost_model->reset();
+            cost_model->set_pipeline_features(ps.pipeline_features, flags.num_cores);
+            const int batch_size = (int)std::min((size_t)1024, ps.schedules.size());
+            Runtime::Buffer<float> runtimes(batch_size);
+            auto it = ps.schedules.begin();
+            for (int j = 0; j < batch_size; j++, it++) {
+                auto &s = *it;
+                Runtime::Buffer<float> buf;
+                cost_model->enqueue(ps.num_stages, &buf, &s.second.prediction);
+                buf.copy_from(s.second.features);
+                runtimes(j) = s.second.runtime;
+            }
+            loss_sum += cost_model->backprop(runtimes, flags.rate);
+            loss_count++;
+        }
+        if (loss_count == 0) {
+            std::cout << "Not enough samples to retrain yet\n";
+            return;
+        }
+        std::cout << "Epoch " << e << " loss: " << loss_sum / loss_count << "\n";
+    }
+    cost_model->save_weights();
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    Flags flags(argc, argv);
+
+    Target target;
+    if (flags.target.empty()) {
+        // Use the host target, but don't train for AVX512 by default.
+        target = get_host_target()
+                     .without_feature(Target::AVX512)
+                     .without_feature(Target::AVX512_KNL)
+                     .without_feature(Target::AVX512_Skylake)
+                     .without_feature(Target::AVX512_Cannonlake);
+    } else {
+        target = Target(flags.target);
+    }
+    target = target.with_feature(Target::DisableLLVMLoopOpt);
+    std::cout << "Training target is: " << target.to_string() << "\n";
+
+    // The autoscheduler is linked into this binary, so it is already
+    // registered.
+    Pipeline::set_default_autoscheduler_name("Adams2019");
+
+    make_dir(flags.samples_dir);
+    const string weights_path = flags.samples_dir + "/updated.weights";
+    if (Internal::file_exists(weights_path)) {
+        std::cout << "Using existing weights " << weights_path << "\n";
+    } else if (!flags.initial_weights_path.empty()) {
+        // Only copy over the weights if we don't have any already,
+        // so that restarted jobs can continue from where they left off
+        copy_file(flags.initial_weights_path, weights_path);
+        std::cout << "Copying starting weights from " << flags.initial_weights_path << " to " << weights_path << "\n";
+    }
+    std::unique_ptr<DefaultCostModel> cost_model =
+        make_default_cost_model(Internal::file_exists(weights_path) ? weights_path : "", weights_path);
+    if (!Internal::file_exists(weights_path)) {
+        // Start from the baseline weights compiled into the cost model.
+        cost_model->save_weights();
+    }
+
+    // Don't clobber existing samples
+    int first_batch = 1;
+    while (Internal::file_exists(flags.samples_dir + "/batch_" + std::to_string(first_batch) + "_0")) {
+        first_batch++;
+    }
+
+    Internal::ThreadPool<void> thread_pool;
+    std::mt19937 rng(0);
+    map<int, PipelineSamples> samples;
+    double best_runtime = std::numeric_limits<double>::infinity();
+
+    for (int batch_id = first_batch; batch_id < first_batch + flags.batches; batch_id++) {
+        const auto batch_start = Tools::benchmark_now();
+        for (size_t args_idx = 0; args_idx < flags.generator_args_sets.size(); args_idx++) {
+            const string dir = flags.samples_dir + "/batch_" + std::to_string(batch_id) + "_" + std::to_string(args_idx);
+            make_dir(dir);
+            // Copy the weights being used into the batch folder so that we can repro failures
+            copy_file(weights_path, dir + "/used.weights");
+
+            GeneratorParamsMap generator_args;
+            for (const string &arg : Flags::split(flags.generator_args_sets[args_idx], ';')) {
+                size_t eq = arg.find('=');
+                if (eq == string::npos) {
+                    std::cerr << "Malformed generator arg: " << arg << "\n";
+                    return 1;
+                }
+                generator_args[arg.substr(0, eq)] = arg.substr(eq + 1);
+            }
+            std::ofstream(dir + "/extra_generator_args.txt") << flags.generator_args_sets[args_idx] << "\n";
+
+            // Autoschedule and lower serially, because the
+            // autoscheduler takes its settings from the environment.
+            std::cout << "Autoscheduling " << flags.batch_size << " samples" << std::flush;
+            vector<std::unique_ptr<Candidate>> candidates;
+            for (int sample_id = 0; sample_id < flags.batch_size; sample_id++) {
+                std::unique_ptr<Candidate> c(new Candidate);
+                c->pipeline_id = (int32_t)args_idx;
+                c->schedule_id = batch_id * 10000 + sample_id;
+                c->dir = dir + "/" + std::to_string(sample_id);
+                char name[256];
+                snprintf(name, sizeof(name), "%s_batch_%04d_sample_%04d", flags.generator.c_str(), batch_id, sample_id);
+                c->name = name;
+                make_dir(c->dir);
+                // Sample 0 in each batch is best effort beam search, with
+                // no randomness. The other samples are random probes
+                // biased by the cost model.
+                const bool greedy = (sample_id == 0);
+                if (build(flags, target, generator_args, weights_path,
+                          greedy ? 32 : 1, greedy ? 100 : 1, c.get())) {
+                    candidates.push_back(std::move(c));
+                } else {
+                    std::cerr << "Autoscheduling failed for " << c->dir << "\n";
+                }
+                std::cout << "." << std::flush;
+            }
+            std::cout << " done.\n";
+
+            // Compile in parallel.
+            std::cout << "Compiling " << candidates.size() << " samples" << std::flush;
+            vector<std::future<void>> compiled;
+            for (auto &c : candidates) {
+                Candidate *candidate = c.get();
+                compiled.emplace_back(thread_pool.async([candidate]() {
+#ifdef HALIDE_WITH_EXCEPTIONS
+                    try {
+                        compile(candidate);
+                    } catch (std::runtime_error &err) {
+                        std::cerr << "Compilation failed for " << candidate->dir << ": " << err.what() << "\n";
+                    }
+#else
+                    compile(candidate);
+#endif
+                }));
+            }
+            for (auto &f : compiled) {
+                f.get();
+                std::cout << "." << std::flush;
+            }
+            std::cout << " done.\n";
+
+            // Benchmark serially, so that the samples don't compete
+            // for the machine.
+            for (auto &c : candidates) {
+                if (!c->compiled) {
+                    continue;
+                }
+                const double runtime = benchmark(flags, c.get(), rng);
+                // The generated code isn't needed any more.
+                c->module = Internal::JITModule();
+                if (runtime < 0) {
+                    std::cerr << "Benchmarking failed for " << c->dir << "\n";
+                    continue;
+                }
+                std::cout << c->name << ": " << runtime * 1000 << " ms\n";
+                const float runtime_ms = (float)(runtime * 1000);
+                write_sample(*c, runtime_ms);
+                add_sample(c->results.featurization, runtime_ms, &samples[c->pipeline_id]);
+
+                if (runtime < best_runtime) {
+                    best_runtime = runtime;
+                    std::ofstream(flags.samples_dir + "/best." + flags.generator + ".schedule.h") << c->results.schedule_source;
+                    std::ofstream(flags.samples_dir + "/best." + flags.generator + ".benchmark.txt")
+                        << "Best runtime is " << runtime_ms << " msec, from schedule id " << c->schedule_id
+                        << " in file " << c->dir << "/" << c->name << ".sample\n";
+                }
+            }
+
+            // Retrain model weights on all samples seen so far. The
+            // next batch picks the new weights up from weights_path.
+            std::cout << "Retraining model...\n";
+            retrain(flags, samples, cost_model.get());
+        }
+        std::cout << "Batch " << batch_id << " took "
+                  << Tools::benchmark_duration_seconds(batch_start, Tools::benchmark_now())
+                  << " seconds to compile, benchmark, and retrain\n";
+    }
+
+    if (best_runtime == std::numeric_limits<double>::infinity()) {
+        std::cerr << "No samples were benchmarked successfully\n";
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,72 @@
+// Measure the throughput of the cost model, in states evaluated per
+// second, for the range of batch sizes the beam search produces. Takes
+// the number of pipeline stages as an optional argument.
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+#include "DefaultCostModel.h"
+#include "HalideBuffer.h"
+#include "NetworkSize.h"
+#include "halide_benchmark.h"
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    const int num_stages = argc > 1 ? atoi(argv[1]) : 16;
+    const int num_cores = 32;
+
+    std::mt19937 rng(0);
+    // Features are mostly counts, spread over many orders of magnitude.
+    std::uniform_real_distribution<float> log_feature(0.0f, 16.0f);
+    auto random_feature = [&]() { return std::floor(std::exp(log_feature(rng))); };
+
+    Runtime::Buffer<float> pipeline_features(head1_w, head1_h, num_stages);
+    pipeline_features.for_each_value([&](float &f) { f = random_feature(); });
+
+    std::vector<Runtime::Buffer<float>> states;
+    for (int i = 0; i < 64; i++) {
+        Runtime::Buffer<float> s(head2_w, num_stages);
+        s.for_each_value([&](float &f) { f = random_feature(); });
+        states.push_back(s);
+    }
+
+    // Use the built-in weights.
+    std::unique_ptr<DefaultCostModel> cost_model = make_default_cost_model();
+    cost_model->set_pipeline_features(pipeline_features, num_cores);
+
+    printf("%d stages\n", num_stages);
+    for (int batch_size : {1, 4, 16, 64, 256, 1024}) {
+        std::vector<double> costs(batch_size);
+        Tools::BenchmarkConfig config;
+        config.min_time = 0.5;
+        config.max_time = 2;
+        double t = Tools::benchmark([&]() {
+                       cost_model->reset();
+                       for (int i = 0; i < batch_size; i++) {
+                           Runtime::Buffer<float> buf;
+                           cost_model->enqueue(num_stages, &buf, &costs[i]);
+                           buf.copy_from(states[i % states.size()]);
+                       }
+                       cost_model->evaluate_costs();
+                   },
+                   config)
+                       .wall_time;
+
+        for (double c : costs) {
+            if (std::isnan(c) || c < 0) {
+                printf("Cost model returned a bad cost: %f\n", c);
+                return -1;
+            }
+        }
+
+        printf("Batch size %4d: %10.0f states/sec (%8.2f us per batch)\n",
+               batch_size, batch_size / t, t * 1e6);
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -485,11 +485,15 @@ public:
             prediction_output.compute_root().split(n, no, n, 8).parallel(no);
             prediction_output.bound(n, 0, batch_size);
 
-            // schedule for the forwards path
+            // schedule for the forwards path. 8 lanes is at least one
+            // native vector everywhere, and divides all the channel
+            // counts. Layers with a multiple of 16 channels use the full
+            // width of AVX-512 where it's available.
             const int vec = 8;
+            const int wide_vec = this->natural_vector_size(Float(32)) >= 16 ? 16 : vec;
 
             // A helper function for scheduling conv layers
-            auto schedule_conv = [&](Func conv, Func relu, RVar r_channels) {
+            auto schedule_conv = [&](Func conv, Func relu, RVar r_channels, int vec) {
                 Var ci, wi;
                 if (!training) {
                     relu
@@ -541,8 +545,10 @@ public:
             }
 
             // conv+relu layers
-            schedule_conv(head2_conv, head2_relu, r_head2.x);
-            schedule_conv(conv1_stage2, relu1, r1_stage2.x);
+            static_assert(head2_channels % vec == 0 && conv1_channels % 16 == 0,
+                          "Vector widths must divide the channel counts");
+            schedule_conv(head2_conv, head2_relu, r_head2.x, vec);
+            schedule_conv(conv1_stage2, relu1, r1_stage2.x, wide_vec);
         }
     }
 };
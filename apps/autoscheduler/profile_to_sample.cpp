@@ -0,0 +1,180 @@
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Turn the output of halide_profiler_report, from a pipeline compiled
+// with the Profile feature and run in production, into a training sample
+// for retrain_cost_model. This is like featurization_to_sample, except
+// that the runtime comes from the profiler instead of a benchmark.
+//
+// The featurization must be the one written (with -e featurization) when
+// the profiled pipeline was compiled. The pipeline id is a hash of the
+// pipeline name, and the schedule id a hash of the featurization, so
+// samples from many reports of the same pipeline and schedule line up
+// when retraining.
+
+namespace {
+
+struct ProfiledPipeline {
+    float ms_per_run = 0;
+    int runs = 0;
+    int samples = 0;
+    // Time per run spent in each Func.
+    std::map<std::string, float> func_ms_per_run;
+};
+
+std::string field_after(const std::string &line, const std::string &key) {
+    size_t pos = line.find(key);
+    if (pos == std::string::npos) {
+        return "";
+    }
+    std::istringstream in(line.substr(pos + key.size()));
+    std::string value;
+    in >> value;
+    return value;
+}
+
+// Parse every pipeline in a profiler report. Each one starts with its
+// name on a line of its own, followed by indented lines of stats, the
+// first of which has the total time and number of runs.
+std::map<std::string, ProfiledPipeline> parse_report(std::istream &in) {
+    std::map<std::string, ProfiledPipeline> result;
+    ProfiledPipeline *current = nullptr;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty()) {
+            continue;
+        }
+        if (line[0] != ' ') {
+            current = &result[line];
+        } else if (current == nullptr) {
+            continue;
+        } else if (line.compare(0, 13, " total time: ") == 0) {
+            float total = (float)atof(field_after(line, "total time:").c_str());
+            current->runs = atoi(field_after(line, "runs:").c_str());
+            current->samples = atoi(field_after(line, "samples:").c_str());
+            current->ms_per_run = current->runs ? total / current->runs : 0;
+        } else if (line.compare(0, 2, "  ") == 0) {
+            size_t colon = line.find(": ");
+            if (colon == std::string::npos) {
+                continue;
+            }
+            std::string name = line.substr(2, colon - 2);
+            current->func_ms_per_run[name] = (float)atof(line.c_str() + colon + 2);
+        }
+    }
+    return result;
+}
+
+// FNV-1a, masked to a positive int32.
+int32_t hash_bytes(const std::string &s) {
+    uint32_t h = 2166136261u;
+    for (char c : s) {
+        h = (h ^ (uint8_t)c) * 16777619u;
+    }
+    return (int32_t)(h & 0x7fffffff);
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    std::vector<std::string> args;
+    std::set<std::string> excluded;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 10, "--exclude=") == 0) {
+            std::istringstream names(arg.substr(10));
+            std::string name;
+            while (std::getline(names, name, ',')) {
+                excluded.insert(name);
+            }
+        } else {
+            args.push_back(arg);
+        }
+    }
+
+    if (args.size() < 4) {
+        std::cout << "Usage: profile_to_sample [--exclude=func,func,...] pipeline_name in.featurization out.sample report.txt [report.txt ...]\n"
+                  << "  The runtime is the fastest time per run over all the reports. Time spent\n"
+                  << "  in excluded Funcs (e.g. extern stages the cost model can't see into) is\n"
+                  << "  subtracted from it.\n";
+        return -1;
+    }
+    const std::string &pipeline_name = args[0];
+
+    std::ifstream src(args[1], std::ios::binary);
+    if (!src) {
+        std::cerr << "Unable to open input file: " << args[1] << "\n";
+        return -1;
+    }
+    std::ostringstream featurization;
+    featurization << src.rdbuf();
+    src.close();
+    if (featurization.str().empty() || featurization.str().size() % sizeof(float) != 0) {
+        std::cerr << "Not a featurization: " << args[1] << "\n";
+        return -1;
+    }
+
+    float best_ms = -1;
+    int total_runs = 0;
+    for (size_t i = 3; i < args.size(); i++) {
+        std::ifstream report(args[i]);
+        if (!report) {
+            std::cerr << "Unable to open profiler report: " << args[i] << "\n";
+            return -1;
+        }
+        std::map<std::string, ProfiledPipeline> pipelines = parse_report(report);
+        auto it = pipelines.find(pipeline_name);
+        if (it == pipelines.end() || it->second.runs == 0) {
+            std::cerr << "No runs of " << pipeline_name << " in " << args[i] << "\n";
+            continue;
+        }
+        const ProfiledPipeline &p = it->second;
+        float ms = p.ms_per_run;
+        for (const std::string &f : excluded) {
+            auto fi = p.func_ms_per_run.find(f);
+            if (fi == p.func_ms_per_run.end()) {
+                std::cerr << "Warning: " << f << " does not appear in " << args[i] << "\n";
+            } else {
+                ms -= fi->second;
+            }
+        }
+        if (ms <= 0) {
+            std::cerr << "Ignoring " << args[i] << ": no time left after exclusions\n";
+            continue;
+        }
+        total_runs += p.runs;
+        if (best_ms < 0 || ms < best_ms) {
+            best_ms = ms;
+        }
+    }
+    if (best_ms < 0) {
+        std::cerr << "No usable profiles of " << pipeline_name << "\n";
+        return -1;
+    }
+
+    std::ofstream dst(args[2], std::ios::binary);
+    if (!dst) {
+        std::cerr << "Unable to open output file: " << args[2] << "\n";
+        return -1;
+    }
+
+    // The sample file stores times in milliseconds.
+    int32_t pid = hash_bytes(pipeline_name);
+    int32_t sid = hash_bytes(featurization.str());
+    dst << featurization.str();
+    dst.write((const char *)&best_ms, 4);
+    dst.write((const char *)&pid, 4);
+    dst.write((const char *)&sid, 4);
+    dst.close();
+
+    std::cout << pipeline_name << ": " << best_ms << " ms over " << total_runs
+              << " runs (pipeline id " << pid << ", schedule id " << sid << ")\n";
+    return 0;
+}
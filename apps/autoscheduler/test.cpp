@@ -1,7 +1,22 @@
 #include "Halide.h"
 
+#include <cstdlib>
+#include <iostream>
+
 using namespace Halide;
 
+namespace {
+
+void set_env(const char *name, const char *value) {
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
+#endif
+}
+
+}  // namespace
+
 int main(int argc, char **argv) {
     // Loads lib auto_schedule.so (or auto_schedule.dll),
     // which is presumed to be in current library search path
@@ -478,5 +493,33 @@ int main(int argc, char **argv) {
         Pipeline(output).auto_schedule(target, params);
     }
 
+
+    if (1) {
+        // The schedule found shouldn't depend on how many threads
+        // expand the beam.
+        auto schedule_with_threads = [&](const char *num_threads) {
+            Func f("f"), g("g"), h("h");
+            f(x, y) = (x + y) * (x + 2 * y) * (x + 3 * y);
+            g(x, y) = f(x - 1, y) + f(x, y) + f(x + 1, y);
+            h(x, y) = g(x, y - 1) + g(x, y) + g(x, y + 1);
+
+            h.set_estimate(x, 0, 2048).set_estimate(y, 0, 2048);
+
+            set_env("HL_AUTOSCHEDULE_NUM_THREADS", num_threads);
+            return Pipeline(h).auto_schedule(target, params).schedule_source;
+        };
+
+        set_env("HL_SEED", "1");
+        std::string serial = schedule_with_threads("1");
+        std::string threaded = schedule_with_threads("8");
+        set_env("HL_AUTOSCHEDULE_NUM_THREADS", "");
+        if (serial != threaded) {
+            std::cerr << "Schedule depends on HL_AUTOSCHEDULE_NUM_THREADS:\n"
+                      << serial << "\nvs\n"
+                      << threaded << "\n";
+            return -1;
+        }
+    }
+
     return 0;
 }
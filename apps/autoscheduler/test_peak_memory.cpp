@@ -0,0 +1,213 @@
+#include "Featurization.h"
+#include "FunctionDAG.h"
+#include "Halide.h"
+#include "LoopNest.h"
+
+#include <iostream>
+#include <map>
+#include <set>
+
+using namespace Halide;
+using namespace Halide::Internal::Autoscheduler;
+using Halide::Internal::IntrusivePtr;
+using Halide::Internal::ScheduleFeatures;
+
+namespace {
+
+const FunctionDAG::Node *find_node(const FunctionDAG &dag, const std::string &name) {
+    for (const auto &n : dag.nodes) {
+        if (n.func.name() == name) {
+            return &n;
+        }
+    }
+    std::cerr << "No node named " << name << "\n";
+    exit(-1);
+}
+
+// Schedule the output h at root, and its producer g either at root
+// or inlined, and return the estimated peak memory use.
+LoopNest::MemoryUse peak_memory_of(const FunctionDAG &dag, const MachineParams &params, bool inline_g) {
+    const FunctionDAG::Node *h = find_node(dag, "h");
+    const FunctionDAG::Node *g = find_node(dag, "g");
+
+    IntrusivePtr<LoopNest> root(new LoopNest);
+    root->compute_here(h, true, 0);
+    root->store_at.insert(h);
+    if (inline_g) {
+        root->inline_func(g);
+    } else {
+        root->compute_here(g, true, 0);
+        root->store_at.insert(g);
+    }
+
+    // peak_memory only looks at the sizes of the realizations and
+    // productions, so fill in just those.
+    StageMap<ScheduleFeatures> features;
+    features.make_large(dag.nodes[0].stages[0].max_id);
+    for (const auto &n : dag.nodes) {
+        auto &feat = features.get_or_create(&(n.stages[0]));
+        feat.bytes_at_realization = 1000 * 1000 * 4;
+        feat.bytes_at_production = 1000 * 1000 * 4;
+    }
+
+    return root->peak_memory(params, features);
+}
+
+using Loops = std::vector<IntrusivePtr<const LoopNest>>;
+
+// A loop over the only stage of f, around the given children and
+// storing the given Funcs.
+IntrusivePtr<const LoopNest> make_loop(const FunctionDAG::Node *f, const std::vector<int64_t> &size,
+                                       bool parallel, const Loops &children,
+                                       const std::set<const FunctionDAG::Node *> &store_at = {}) {
+    LoopNest *loop = new LoopNest;
+    loop->node = f;
+    loop->stage = &(f->stages[0]);
+    loop->size = size;
+    loop->parallel = parallel;
+    loop->children = children;
+    loop->innermost = children.empty();
+    loop->store_at = store_at;
+    return loop;
+}
+
+// The features peak_memory looks at, for the Funcs stored somewhere.
+StageMap<ScheduleFeatures> make_features(const FunctionDAG &dag,
+                                         const std::map<std::string, std::pair<int64_t, int64_t>> &bytes) {
+    StageMap<ScheduleFeatures> features;
+    features.make_large(dag.nodes[0].stages[0].max_id);
+    for (const auto &n : dag.nodes) {
+        auto &feat = features.get_or_create(&(n.stages[0]));
+        auto it = bytes.find(n.func.name());
+        if (it != bytes.end()) {
+            feat.bytes_at_realization = it->second.first;
+            feat.bytes_at_production = it->second.second;
+        }
+    }
+    return features;
+}
+
+bool check(const char *what, const LoopNest::MemoryUse &m, int64_t heap, int64_t stack) {
+    if (m.heap != heap || m.stack != stack) {
+        std::cerr << what << ": expected " << heap << " bytes of heap and "
+                  << stack << " of stack, got " << m.heap << " and " << m.stack << "\n";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    // Use a fixed target for the analysis to get consistent results from this test.
+    MachineParams params(32, 16000000, 40);
+    Target target("x86-64-linux-sse41-avx-avx2");
+
+    Var x("x"), y("y");
+    Func g("g"), h("h");
+    g(x, y) = (x + y) * (x + y);
+    h(x, y) = g(x, y) * 2 + g(x + 1, y);
+    h.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
+
+    std::vector<Internal::Function> outputs = {h.function()};
+    FunctionDAG dag(outputs, params, target);
+
+    // A compute_root producer is a heap allocation that's live for
+    // the whole pipeline. The output is allocated by the caller, so
+    // it doesn't count.
+    LoopNest::MemoryUse root = peak_memory_of(dag, params, false);
+    if (root.heap != 1000 * 1000 * 4 || root.stack != 0) {
+        std::cerr << "compute_root producer: expected " << 1000 * 1000 * 4
+                  << " bytes of heap and none of stack, got "
+                  << root.heap << " and " << root.stack << "\n";
+        return -1;
+    }
+
+    // An inlined producer allocates nothing.
+    LoopNest::MemoryUse inlined = peak_memory_of(dag, params, true);
+    if (inlined.heap != 0 || inlined.stack != 0) {
+        std::cerr << "Inlined producer: expected no allocations, got "
+                  << inlined.heap << " bytes of heap and "
+                  << inlined.stack << " of stack\n";
+        return -1;
+    }
+
+    // A chain of producers a -> b -> c -> out, for the loop nests
+    // below, which are built by hand.
+    Func a("a"), b("b"), c("c"), out("out");
+    a(x, y) = x + y;
+    b(x, y) = a(x, y) + a(x + 1, y);
+    c(x, y) = b(x, y) + b(x, y + 1);
+    out(x, y) = c(x, y) * 2;
+    out.set_estimate(x, 0, 1000).set_estimate(y, 0, 1000);
+    std::vector<Internal::Function> chain_outputs = {out.function()};
+    FunctionDAG chain(chain_outputs, params, target);
+    const FunctionDAG::Node *na = find_node(chain, "a"), *nb = find_node(chain, "b");
+    const FunctionDAG::Node *nc = find_node(chain, "c"), *nout = find_node(chain, "out");
+
+    // All compute_root: each producer is live from the loop that
+    // computes it to the loop that consumes it, so a and b overlap, and
+    // then b and c, but a is freed before c is allocated.
+    {
+        IntrusivePtr<LoopNest> root(new LoopNest);
+        root->children = Loops{make_loop(na, {1000, 1000}, false, {}),
+                               make_loop(nb, {1000, 1000}, false, {}),
+                               make_loop(nc, {1000, 1000}, false, {}),
+                               make_loop(nout, {1000, 1000}, false, {})};
+        root->store_at = {na, nb, nc, nout};
+        auto features = make_features(chain, {{"a", {4000000, 4000000}},
+                                              {"b", {1000000, 1000000}},
+                                              {"c", {2000000, 2000000}}});
+        if (!check("Overlapping lifetimes", root->peak_memory(params, features), 5000000, 0)) {
+            return -1;
+        }
+    }
+
+    // c stored at root but computed per row of out can be folded down to
+    // two rows, which is still a heap allocation at root.
+    {
+        IntrusivePtr<LoopNest> root(new LoopNest);
+        root->children = Loops{make_loop(nout, {1000}, false,
+                                         {make_loop(nc, {1000}, false, {}),
+                                          make_loop(nout, {1000}, false, {})})};
+        root->store_at = {nc, nout};
+        auto features = make_features(chain, {{"c", {4000000, 4000}}});
+        if (!check("Folded producer", root->peak_memory(params, features), 8000, 0)) {
+            return -1;
+        }
+    }
+
+    // c stored and computed per row of out. A small row goes on the
+    // stack, and a large one on the heap. Under a parallel loop, there
+    // is one allocation per concurrent task, which is the smaller of
+    // the loop's extent and the parallelism.
+    struct {
+        int64_t rows;
+        bool parallel;
+        int64_t row_bytes;
+        int64_t heap, stack;
+    } per_row[] = {
+        {1000, false, 4000, 0, 4000},
+        {1000, false, 40000, 40000, 0},
+        {1000, true, 4000, 0, 32 * 4000},
+        {1000, true, 40000, 32 * 40000, 0},
+        {8, true, 40000, 8 * 40000, 0},
+    };
+    for (const auto &r : per_row) {
+        IntrusivePtr<LoopNest> root(new LoopNest);
+        root->children = Loops{make_loop(nout, {r.rows}, r.parallel,
+                                         {make_loop(nc, {1000}, false, {}),
+                                          make_loop(nout, {1000}, false, {})},
+                                         {nc})};
+        root->store_at = {nout};
+        auto features = make_features(chain, {{"c", {r.row_bytes, r.row_bytes}}});
+        if (!check(r.parallel ? "Per-row producer in a parallel loop" : "Per-row producer",
+                   root->peak_memory(params, features), r.heap, r.stack)) {
+            std::cerr << "(" << r.rows << " rows of " << r.row_bytes << " bytes)\n";
+            return -1;
+        }
+    }
+
+    std::cout << "Success!\n";
+    return 0;
+}
@@ -817,6 +817,328 @@ void apply_schedule(const MachineParams &params,
     schedule_source << ";\n";
 }
 
+// On CPU, a Func whose pure definition is split into cache-sized tiles,
+// along with the producers that are computed inside each tile instead
+// of at root.
+struct TileGroup {
+    std::string root;
+    std::vector<std::string> members;
+    // The tile size in each of the innermost one or two dimensions.
+    std::vector<int> tile_sizes;
+    // The loop over tiles the members are computed at.
+    Var tile_var;
+};
+
+int64_t bytes_per_point(const Function &f) {
+    int64_t bytes = 0;
+    for (const Type &t : f.output_types()) {
+        bytes += t.bytes();
+    }
+    return bytes;
+}
+
+// The bytes of intermediates computed for one tile should fit in the
+// cache private to a core, with room left over for the inputs they read.
+int64_t tile_budget_bytes(const MachineParams &params) {
+    int64_t cache = params.l2_cache_size > 0 ?
+                        (int64_t)params.l2_cache_size :
+                        params.last_level_cache_size / std::max(1, params.parallelism);
+    return std::max<int64_t>(cache / 2, 16 * 1024);
+}
+
+// Estimate how much of f is needed to compute one tile of a root with
+// the given bounds. The tiled dimensions grow by however much larger f
+// is than the root (its halo), and the other dimensions are needed in
+// full.
+int64_t tile_footprint(const Function &f,
+                       const std::vector<int> &bounds,
+                       const std::vector<int> &root_bounds,
+                       const std::vector<int> &tile_sizes) {
+    int64_t points = 1;
+    for (int d = 0; d < (int)bounds.size(); d++) {
+        if (d < (int)tile_sizes.size()) {
+            points *= tile_sizes[d] + bounds[d] - root_bounds[d];
+        } else {
+            points *= bounds[d];
+        }
+    }
+    return points * bytes_per_point(f);
+}
+
+// How many times over f is computed when it is computed per tile
+// instead of once at root.
+double recompute_factor(const std::vector<int> &bounds,
+                        const std::vector<int> &root_bounds,
+                        const std::vector<int> &tile_sizes) {
+    double factor = 1;
+    for (int d = 0; d < (int)tile_sizes.size(); d++) {
+        factor *= (double)(tile_sizes[d] + bounds[d] - root_bounds[d]) / tile_sizes[d];
+    }
+    return factor;
+}
+
+// Pick tile sizes for a group so that everything computed per tile fits
+// in the budget, while still leaving a task per core.
+std::vector<int> choose_tile_sizes(const MachineParams &params,
+                                   int vector_size,
+                                   const std::map<std::string, Function> &env,
+                                   const std::map<std::string, std::vector<int>> &func_int_bounds,
+                                   const std::string &root,
+                                   const std::vector<std::string> &members) {
+    const std::vector<int> &root_bounds = func_int_bounds.at(root);
+    std::vector<int> tile_sizes;
+    tile_sizes.push_back(std::max(vector_size, std::min(root_bounds[0], 256) / vector_size * vector_size));
+    if (root_bounds.size() > 1) {
+        tile_sizes.push_back(std::min(root_bounds[1], 128));
+    }
+
+    auto footprint = [&]() {
+        int64_t bytes = tile_footprint(env.at(root), root_bounds, root_bounds, tile_sizes);
+        for (const std::string &m : members) {
+            bytes += tile_footprint(env.at(m), func_int_bounds.at(m), root_bounds, tile_sizes);
+        }
+        return bytes;
+    };
+    auto shrink = [&](int d) {
+        if (d == 0) {
+            if (tile_sizes[0] <= vector_size) {
+                return false;
+            }
+            tile_sizes[0] = std::max(vector_size, tile_sizes[0] / 2 / vector_size * vector_size);
+        } else {
+            if (tile_sizes[d] <= 1) {
+                return false;
+            }
+            tile_sizes[d] /= 2;
+        }
+        return true;
+    };
+
+    const int64_t budget = tile_budget_bytes(params);
+    while (footprint() > budget) {
+        // Keep tiles a little wider than they are tall, since rows are
+        // contiguous in memory.
+        bool prefer_y = tile_sizes.size() > 1 && tile_sizes[1] * 2 > tile_sizes[0];
+        if (!(prefer_y && shrink(1)) && !shrink(0) && !(tile_sizes.size() > 1 && shrink(1))) {
+            break;
+        }
+    }
+
+    // The outermost tiled loop is fused with the remaining dimensions and
+    // parallelized.
+    const int outer = (int)tile_sizes.size() - 1;
+    auto num_tasks = [&]() {
+        int64_t tasks = (root_bounds[outer] + tile_sizes[outer] - 1) / tile_sizes[outer];
+        for (int d = outer + 1; d < (int)root_bounds.size(); d++) {
+            tasks *= root_bounds[d];
+        }
+        return tasks;
+    };
+    while (num_tasks() < params.parallelism && shrink(outer)) {
+    }
+    return tile_sizes;
+}
+
+// Group Funcs into tiles, from the outputs in. A Func joins a tile group
+// if all of its callers are in that group and recomputing its halo per
+// tile is cheap, or if it is too large to reasonably compute at root.
+// Funcs that can't join a group start their own, if their pure definition
+// can be tiled. Groups without members are left to the usual schedule.
+std::vector<TileGroup> find_tile_groups(const MachineParams &params,
+                                        const Target &target,
+                                        const std::vector<std::string> &order,
+                                        const std::map<std::string, Function> &env,
+                                        const std::set<std::string> &output_set,
+                                        const std::map<std::string, std::vector<int>> &func_int_bounds) {
+    std::map<std::string, std::set<std::string>> callers;
+    for (const auto &it : env) {
+        for (const auto &callee : find_direct_calls(it.second)) {
+            if (callee.first != it.first) {
+                callers[callee.first].insert(it.first);
+            }
+        }
+    }
+
+    // Computing a Func this large at root is likely to run out of memory,
+    // so fuse it into its consumer regardless of the cost of recomputing
+    // its halo.
+    const int64_t max_root_bytes = std::max<int64_t>(params.last_level_cache_size, 1024 * 1024) * 16;
+    constexpr double max_recompute_factor = 1.5;
+
+    std::vector<TileGroup> groups;
+    std::map<std::string, int> group_of;
+    for (auto it = order.rbegin(); it != order.rend(); it++) {
+        const std::string &name = *it;
+        const Function &f = env.at(name);
+        const std::vector<int> &bounds = func_int_bounds.at(name);
+        if (f.has_extern_definition() || bounds.empty()) {
+            continue;
+        }
+
+        int g = -1;
+        bool can_join = !output_set.count(name) && !callers[name].empty();
+        for (const std::string &c : callers[name]) {
+            auto gi = group_of.find(c);
+            if (gi == group_of.end() || (g != -1 && gi->second != g)) {
+                can_join = false;
+                break;
+            }
+            g = gi->second;
+        }
+        // Only reductions over the pure variables can be computed per
+        // tile without recomputing the whole reduction domain.
+        for (const Definition &def : f.updates()) {
+            for (int i = 0; can_join && i < (int)def.args().size(); i++) {
+                const Variable *var = def.args()[i].as<Variable>();
+                can_join = var && var->name == f.args()[i];
+            }
+        }
+        if (can_join) {
+            TileGroup &group = groups[g];
+            const std::vector<int> &root_bounds = func_int_bounds.at(group.root);
+            // f must cover the tiled dimensions of the root. Anything
+            // smaller (e.g. a lookup table or a downsampled level) is
+            // likely indexed in a way that tiling doesn't help.
+            can_join = bounds.size() >= group.tile_sizes.size();
+            for (int d = 0; can_join && d < (int)group.tile_sizes.size(); d++) {
+                can_join = bounds[d] >= root_bounds[d];
+            }
+            if (can_join) {
+                std::vector<std::string> members = group.members;
+                members.push_back(name);
+                const Function &root = env.at(group.root);
+                std::vector<int> tile_sizes =
+                    choose_tile_sizes(params, natural_vector_size(target, root.output_types()[0]),
+                                      env, func_int_bounds, group.root, members);
+                int64_t points = 1;
+                for (int b : bounds) {
+                    points *= b;
+                }
+                bool too_large = points * bytes_per_point(f) > max_root_bytes;
+                if (too_large ||
+                    recompute_factor(bounds, root_bounds, tile_sizes) <= max_recompute_factor) {
+                    group.members.push_back(name);
+                    group_of[name] = g;
+                    continue;
+                }
+            }
+        }
+
+        const int vector_size = natural_vector_size(target, f.output_types()[0]);
+        if (f.updates().empty() && bounds[0] >= vector_size) {
+            group_of[name] = (int)groups.size();
+            groups.push_back({name, {}, {}, Var()});
+            groups.back().tile_sizes =
+                choose_tile_sizes(params, vector_size, env, func_int_bounds, name, {});
+        }
+    }
+
+    std::vector<TileGroup> result;
+    for (TileGroup &group : groups) {
+        if (!group.members.empty()) {
+            const Function &root = env.at(group.root);
+            group.tile_sizes =
+                choose_tile_sizes(params, natural_vector_size(target, root.output_types()[0]),
+                                  env, func_int_bounds, group.root, group.members);
+            result.push_back(group);
+        }
+    }
+    return result;
+}
+
+void apply_tiled_schedule(const Target &target,
+                          Func func,
+                          TileGroup &group,
+                          std::ostringstream &schedule_source) {
+    const std::vector<Var> vars = func.args();
+    const std::vector<int> &tile_sizes = group.tile_sizes;
+    const TailStrategy tail = TailStrategy::ShiftInwards;
+    func.compute_root();
+    schedule_source << func.name() << ".compute_root()\n";
+
+    std::vector<Var> inner, outer;
+    for (int d = 0; d < (int)tile_sizes.size(); d++) {
+        Var o, i;
+        func.split(vars[d], o, i, tile_sizes[d], tail);
+        schedule_source << "    .split("
+                        << vars[d].name() << ","
+                        << o.name() << ","
+                        << i.name() << ","
+                        << tile_sizes[d] << ","
+                        << tail << ")\n";
+        outer.push_back(o);
+        inner.push_back(i);
+    }
+    if (tile_sizes.size() > 1) {
+        std::vector<VarOrRVar> all_vars{inner[0], inner[1], outer[0], outer[1]};
+        func.reorder(all_vars);
+        schedule_source << "    .reorder("
+                        << inner[0].name() << ","
+                        << inner[1].name() << ","
+                        << outer[0].name() << ","
+                        << outer[1].name() << ")\n";
+    }
+
+    // Fuse the outermost tile loop with the untiled dimensions, inner to
+    // outer, and parallelize it.
+    Var fused_var = outer.back();
+    for (int d = (int)tile_sizes.size(); d < (int)vars.size(); d++) {
+        func.fuse(fused_var, vars[d], fused_var);
+        schedule_source << "    .fuse("
+                        << fused_var.name() << ","
+                        << vars[d].name() << ","
+                        << fused_var.name() << ")\n";
+    }
+    func.parallel(fused_var);
+    schedule_source << "    .parallel(" << fused_var.name() << ")\n";
+
+    const int vector_size = natural_vector_size(target, func.values()[0].type());
+    func.vectorize(inner[0], vector_size, tail);
+    schedule_source << "    .vectorize("
+                    << inner[0].name() << ","
+                    << vector_size << ","
+                    << tail << ")\n";
+    schedule_source << ";\n";
+
+    group.tile_var = outer[0];
+}
+
+void apply_tile_member_schedule(const Target &target,
+                                Func func,
+                                Func root,
+                                const TileGroup &group,
+                                const std::vector<int> &var_bounds,
+                                std::ostringstream &schedule_source) {
+    func.compute_at(root, group.tile_var);
+    schedule_source << func.name() << ".compute_at("
+                    << group.root << ","
+                    << group.tile_var.name() << ")\n";
+
+    // The tiles are already parallel, so just vectorize the innermost
+    // dimension of each definition.
+    const int vector_size = natural_vector_size(target, func.values()[0].type());
+    const Var v = func.args()[0];
+    if (var_bounds[0] >= vector_size) {
+        func.vectorize(v, vector_size, TailStrategy::ShiftInwards);
+        schedule_source << "    .vectorize("
+                        << v.name() << ","
+                        << vector_size << ","
+                        << TailStrategy::ShiftInwards << ")\n";
+    }
+    schedule_source << ";\n";
+    for (int update_id = 0; update_id < func.num_update_definitions(); update_id++) {
+        if (var_bounds[0] >= vector_size) {
+            func.update(update_id).vectorize(v, vector_size, TailStrategy::GuardWithIf);
+            schedule_source << func.name() << ".update(" << update_id << ")\n"
+                            << "    .vectorize("
+                            << v.name() << ","
+                            << vector_size << ","
+                            << TailStrategy::GuardWithIf << ")\n"
+                            << ";\n";
+        }
+    }
+}
+
 }  // namespace
 
 void generate_schedule(const std::vector<Function> &outputs,
@@ -906,14 +1228,42 @@ void generate_schedule(const std::vector<Function> &outputs,
         output_set.insert(output.name());
     }
 
+    // Get the bounds in integer constant by substitute all the parameters' estimates.
+    std::map<std::string, std::vector<int>> func_int_bounds;
+    for (const auto &name : order) {
+        func_int_bounds[name] = get_int_bounds(func_bounds[name]);
+    }
+
+    // On CPU, tile consumers to fit in cache and compute their producers
+    // per tile, instead of computing everything at root.
+    std::vector<TileGroup> tile_groups;
+    if (!target.has_gpu_feature()) {
+        tile_groups = find_tile_groups(params, target, order, env, output_set, func_int_bounds);
+    }
+    std::map<std::string, int> tile_root_of, tile_member_of;
+    for (int g = 0; g < (int)tile_groups.size(); g++) {
+        tile_root_of[tile_groups[g].root] = g;
+        for (const std::string &m : tile_groups[g].members) {
+            tile_member_of[m] = g;
+        }
+    }
+
     std::ostringstream schedule_source;
     // Traverse from the consumers to the producers
     for (auto it = order.rbegin(); it != order.rend(); it++) {
         Func func(env[*it]);
         aslog(1) << "[gradient_autoscheduler] Processing function:" << *it << "\n";
-        // Get the bounds in integer constant by substitute all the parameters' estimates.
-        Box bounds = func_bounds[*it];
-        std::vector<int> int_bounds = get_int_bounds(bounds);
+        const std::vector<int> &int_bounds = func_int_bounds[*it];
+        if (tile_root_of.count(*it)) {
+            apply_tiled_schedule(target, func, tile_groups[tile_root_of[*it]], schedule_source);
+            continue;
+        }
+        if (tile_member_of.count(*it)) {
+            const TileGroup &group = tile_groups[tile_member_of[*it]];
+            apply_tile_member_schedule(target, func, Func(env[group.root]), group,
+                                       int_bounds, schedule_source);
+            continue;
+        }
         // Scheduling pure definition
         apply_schedule(params, target, func, -1, int_bounds, target.has_gpu_feature(), schedule_source);
         // Scheduling the updates
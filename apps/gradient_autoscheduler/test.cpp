@@ -81,6 +81,62 @@ int main(int argc, char **argv) {
                   << result.schedule_source << "\n\n";
     }
 
+    {  // 2D stencil chain. Should compute the blurs per tile of the output.
+        Func in("in");
+        in(x, y) = cast<float>(x + y);
+        Func blur_x("blur_x");
+        blur_x(x, y) = (in(x - 1, y) + in(x, y) + in(x + 1, y)) / 3.f;
+        Func blur_y("blur_y");
+        blur_y(x, y) = (blur_x(x, y - 1) + blur_x(x, y) + blur_x(x, y + 1)) / 3.f;
+        Func f0("f0");
+        f0(x, y) = blur_y(x, y) + blur_y(x + 1, y + 1);
+
+        f0.set_estimate(x, 0, 2048)
+            .set_estimate(y, 0, 2048);
+
+        Target jit_target = get_jit_target_from_environment();
+        AutoSchedulerResults result =
+            Pipeline(f0).auto_schedule(jit_target, params);
+        std::cout << "Schedule for 2D stencil chain:\n"
+                  << result.schedule_source << "\n\n";
+
+        // Everything should be in one group rooted at f0. The largest
+        // tiles whose per-tile footprint of the four Funcs fits in half
+        // of the 16MB / 32 cores of cache, that still leave a tile per
+        // core, are 128x64.
+        const std::vector<Internal::Split> &splits =
+            f0.function().definition().schedule().splits();
+        if (splits.size() < 2 ||
+            splits[0].old_var != "x" || !Internal::is_const(splits[0].factor, 128) ||
+            splits[1].old_var != "y" || !Internal::is_const(splits[1].factor, 64)) {
+            std::cerr << "f0 should be split into 128x64 tiles\n";
+            return 1;
+        }
+        for (Func member : {blur_y, blur_x, in}) {
+            LoopLevel level = member.function().schedule().compute_level();
+            level.lock();
+            if (level.is_inlined() || level.is_root() ||
+                level.func() != f0.name() || level.var().name() != splits[0].outer) {
+                std::cerr << member.name() << " should be computed per tile of f0, not at "
+                          << level.to_string() << "\n";
+                return 1;
+            }
+        }
+
+        // The blurs of x + y are x + y again, exactly.
+        Buffer<float> out = f0.realize(2048, 2048, jit_target);
+        for (int yi = 0; yi < out.height(); yi++) {
+            for (int xi = 0; xi < out.width(); xi++) {
+                float correct = 2.f * (xi + yi) + 2.f;
+                if (out(xi, yi) != correct) {
+                    std::cerr << "f0(" << xi << ", " << yi << ") = " << out(xi, yi)
+                              << " instead of " << correct << "\n";
+                    return 1;
+                }
+            }
+        }
+    }
+
     {  // 1D Histogram.
         Func in("in");
         in(x) = x % 10;
@@ -0,0 +1,48 @@
+#!/bin/bash
+#
+# Report how long the default autoscheduler takes on each of the apps.
+#
+# $@ = apps to time (defaults to the ones below)
+#
+# Each app's generator is built with its own Makefile, then run with
+# auto_schedule=false and auto_schedule=true. The difference between the
+# two is the time spent autoscheduling. Set HL_MACHINE_PARAMS or
+# HL_AUTOSCHEDULER_RUNS (default 3; the best run is reported) to change
+# how it runs.
+
+APPS_DIR=$(cd "$(dirname "$0")/.." && pwd)
+APPS=${@:-bilateral_grid camera_pipe conv_layer harris iir_blur interpolate lens_blur local_laplacian max_filter nl_means stencil_chain unsharp}
+RUNS=${HL_AUTOSCHEDULER_RUNS:-3}
+OUT=$(mktemp -d /tmp/time_auto_schedule.XXXXXX)
+trap 'rm -rf "${OUT}"' EXIT
+
+# Run the generator $1 for app $2 with auto_schedule=$3, and print the
+# fastest wall-clock time in seconds over $RUNS runs.
+best_time() {
+    local best=""
+    for ((i = 0; i < RUNS; i++)); do
+        local start=$(date +%s.%N)
+        "$1" -g "$2" -e schedule -o "${OUT}" target=host auto_schedule=$3 > /dev/null 2>&1 || return 1
+        local t=$(echo "$(date +%s.%N) - ${start}" | bc)
+        if [[ -z "${best}" ]] || (( $(echo "${t} < ${best}" | bc) )); then
+            best=${t}
+        fi
+    done
+    echo "${best}"
+}
+
+printf "%-20s %12s\n" "app" "autoschedule"
+for APP in ${APPS}; do
+    GENERATOR=${APPS_DIR}/${APP}/bin/host/${APP}.generator
+    if ! make -C "${APPS_DIR}/${APP}" "bin/host/${APP}.generator" > /dev/null 2>&1; then
+        printf "%-20s %12s\n" "${APP}" "build failed"
+        continue
+    fi
+    MANUAL=$(best_time "${GENERATOR}" "${APP}" false)
+    AUTO=$(best_time "${GENERATOR}" "${APP}" true)
+    if [[ -z "${MANUAL}" || -z "${AUTO}" ]]; then
+        printf "%-20s %12s\n" "${APP}" "failed"
+        continue
+    fi
+    printf "%-20s %11.3fs\n" "${APP}" "$(echo "${AUTO} - ${MANUAL}" | bc)"
+done
@@ -25,12 +25,23 @@ void define_derivative(py::module &m) {
                 return d(std::get<0>(args), std::get<1>(args));
             });
 
+    py::class_<GradientCheckpoints>(m, "GradientCheckpoints")
+        .def(py::init<>())
+        .def_readwrite("funcs", &GradientCheckpoints::funcs)
+        .def_readwrite("memory_budget", &GradientCheckpoints::memory_budget);
+
     m.def("propagate_adjoints",
           (Derivative(*)(const Func &, const Func &, const Region &)) & propagate_adjoints);
     m.def("propagate_adjoints",
           (Derivative(*)(const Func &, const Buffer<float> &)) & propagate_adjoints);
     m.def("propagate_adjoints",
           (Derivative(*)(const Func &)) & propagate_adjoints);
+    m.def("propagate_adjoints",
+          (Derivative(*)(const Func &, const Func &, const Region &, const GradientCheckpoints &)) & propagate_adjoints);
+    m.def("propagate_adjoints",
+          (Derivative(*)(const Func &, const Buffer<float> &, const GradientCheckpoints &)) & propagate_adjoints);
+    m.def("propagate_adjoints",
+          (Derivative(*)(const Func &, const GradientCheckpoints &)) & propagate_adjoints);
 }
 
 }  // namespace PythonBindings
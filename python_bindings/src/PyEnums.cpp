@@ -31,6 +31,11 @@ void define_enums(py::module &m) {
         .value("NoAlign", LoopAlignStrategy::NoAlign)
         .value("Auto", LoopAlignStrategy::Auto);
 
+    py::enum_<TileOrder>(m, "TileOrder")
+        .value("RowMajor", TileOrder::RowMajor)
+        .value("Morton", TileOrder::Morton)
+        .value("Hilbert", TileOrder::Hilbert);
+
     py::enum_<MemoryType>(m, "MemoryType")
         .value("Auto", MemoryType::Auto)
         .value("Heap", MemoryType::Heap)
@@ -144,6 +149,8 @@ void define_enums(py::module &m) {
         .value("SVE", Target::Feature::SVE)
         .value("SVE2", Target::Feature::SVE2)
         .value("ARMDotProd", Target::Feature::ARMDotProd)
+        .value("LoopCarry", Target::Feature::LoopCarry)
+        .value("FuseSiblings", Target::Feature::FuseSiblings)
         .value("FeatureEnd", Target::Feature::FeatureEnd);
 
     py::enum_<halide_type_code_t>(m, "TypeCode")
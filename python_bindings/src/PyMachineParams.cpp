@@ -12,11 +12,24 @@ void define_machine_params(py::module &m) {
             .def_readwrite("parallelism", &MachineParams::parallelism)
             .def_readwrite("last_level_cache_size", &MachineParams::last_level_cache_size)
             .def_readwrite("balance", &MachineParams::balance)
+            .def_readwrite("l1_cache_size", &MachineParams::l1_cache_size)
+            .def_readwrite("l2_cache_size", &MachineParams::l2_cache_size)
+            .def_readwrite("vector_width", &MachineParams::vector_width)
+            .def_readwrite("cores_per_numa_node", &MachineParams::cores_per_numa_node)
             .def_static("generic", &MachineParams::generic)
+            .def_static("host", &MachineParams::host)
             .def("__str__", &MachineParams::to_string)
             .def("__repr__", [](const MachineParams &mp) -> std::string {
                 std::ostringstream o;
-                o << "<halide.MachineParams " << mp.to_string() << ">";
+                o << "<halide.MachineParams"
+                  << " parallelism=" << mp.parallelism
+                  << " last_level_cache_size=" << mp.last_level_cache_size
+                  << " balance=" << mp.balance
+                  << " l1_cache_size=" << mp.l1_cache_size
+                  << " l2_cache_size=" << mp.l2_cache_size
+                  << " vector_width=" << mp.vector_width
+                  << " cores_per_numa_node=" << mp.cores_per_numa_node
+                  << ">";
                 return o.str();
             });
 }
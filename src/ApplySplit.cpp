@@ -11,6 +11,100 @@ using std::map;
 using std::string;
 using std::vector;
 
+namespace {
+
+// Fused loops that walk a space-filling curve support blocks of up to
+// 2^15 x 2^15 points, so that the index within a block fits in an
+// Int(32). Loops too large for that are fused in row-major order
+// instead.
+const int max_curve_bits = 15;
+
+// Gather the even bits of x into the low half.
+Expr compact_even_bits(Expr x) {
+    x = x & 0x55555555;
+    x = (x | (x >> 1)) & 0x33333333;
+    x = (x | (x >> 2)) & 0x0f0f0f0f;
+    x = (x | (x >> 4)) & 0x00ff00ff;
+    x = (x | (x >> 8)) & 0x0000ffff;
+    return x;
+}
+
+// Define the offsets of the inner and outer dimensions of a fuse that
+// walks a space-filling curve, in terms of the fused var. The fused
+// var enumerates square blocks of side 2^bits, laid end to end along
+// the longer of the two dimensions, and the curve covers each block
+// in turn. If the loops are too large for a curve (see
+// compute_loop_bounds_after_split), the offsets are row-major
+// instead. Returns the lets that define the offsets (named
+// <name>.curve_inner and <name>.curve_outer), from innermost to
+// outermost.
+vector<ApplySplitResult> curve_offsets(const Split &split, const string &prefix) {
+    vector<ApplySplitResult> lets;
+
+    const string name = prefix + split.old_var;
+    Expr fused = Variable::make(Int(32), name);
+    Expr bits = Variable::make(Int(32), name + ".curve_bits");
+    Expr fits = Variable::make(Bool(), name + ".curve_fits");
+    Expr inner_extent = Variable::make(Int(32), prefix + split.inner + ".loop_extent");
+    Expr outer_extent = Variable::make(Int(32), prefix + split.outer + ".loop_extent");
+
+    Expr block = Variable::make(Int(32), name + ".curve_block");
+    Expr index = Variable::make(Int(32), name + ".curve_index");
+    Expr along = Variable::make(Int(32), name + ".curve_along");
+    Expr across = Variable::make(Int(32), name + ".curve_across");
+
+    // Offsets of the point along and across the run of blocks.
+    Expr long_inner = inner_extent >= outer_extent;
+    Expr block_start = block << bits;
+    lets.emplace_back(name + ".curve_inner",
+                      select(fits, select(long_inner, block_start + along, across), fused % inner_extent),
+                      ApplySplitResult::LetStmt);
+    lets.emplace_back(name + ".curve_outer",
+                      select(fits, select(long_inner, across, block_start + along), fused / inner_extent),
+                      ApplySplitResult::LetStmt);
+
+    if (split.order == TileOrder::Morton) {
+        lets.emplace_back(name + ".curve_along", compact_even_bits(index), ApplySplitResult::LetStmt);
+        lets.emplace_back(name + ".curve_across", compact_even_bits(index >> 1), ApplySplitResult::LetStmt);
+    } else {
+        internal_assert(split.order == TileOrder::Hilbert);
+        // The usual iterative conversion from distance along a Hilbert
+        // curve to coordinates, unrolled to the largest supported
+        // block, with the levels beyond the block size disabled. Each
+        // level is a let, so that the expressions stay small.
+        vector<ApplySplitResult> levels;
+        Expr x = 0, y = 0, t = index;
+        for (int level = 0; level < max_curve_bits; level++) {
+            const string level_name = name + ".curve_level." + std::to_string(level);
+            const int s = 1 << level;
+            Expr active = level < bits;
+            Expr rx = (t >> 1) & 1;
+            Expr ry = (t ^ rx) & 1;
+            Expr flip = (ry == 0) && (rx == 1);
+            Expr fx = select(flip, s - 1 - x, x);
+            Expr fy = select(flip, s - 1 - y, y);
+            Expr new_x = select(ry == 0, fy, fx) + rx * s;
+            Expr new_y = select(ry == 0, fx, fy) + ry * s;
+
+            levels.emplace_back(level_name + ".x", select(active, new_x, x), ApplySplitResult::LetStmt);
+            levels.emplace_back(level_name + ".y", select(active, new_y, y), ApplySplitResult::LetStmt);
+            levels.emplace_back(level_name + ".t", t >> 2, ApplySplitResult::LetStmt);
+            x = Variable::make(Int(32), level_name + ".x");
+            y = Variable::make(Int(32), level_name + ".y");
+            t = Variable::make(Int(32), level_name + ".t");
+        }
+        lets.emplace_back(name + ".curve_along", x, ApplySplitResult::LetStmt);
+        lets.emplace_back(name + ".curve_across", y, ApplySplitResult::LetStmt);
+        lets.insert(lets.end(), levels.rbegin(), levels.rend());
+    }
+
+    lets.emplace_back(name + ".curve_index", fused & ((Expr(1) << (bits * 2)) - 1), ApplySplitResult::LetStmt);
+    lets.emplace_back(name + ".curve_block", fused >> (bits * 2), ApplySplitResult::LetStmt);
+    return lets;
+}
+
+}  // namespace
+
 vector<ApplySplitResult> apply_split(const Split &split, bool is_update, const string &prefix,
                                      map<string, Expr> &dim_extent_alignment) {
     vector<ApplySplitResult> result;
@@ -89,6 +183,31 @@ vector<ApplySplitResult> apply_split(const Split &split, bool is_update, const s
         result.emplace_back(old_var_name, base_var + inner, ApplySplitResult::LetStmt);
         result.emplace_back(base_name, base, ApplySplitResult::LetStmt);
 
+    } else if (split.is_fuse() && split.order != TileOrder::RowMajor) {
+        // Define the inner and outer in terms of the position along a
+        // space-filling curve. The fused var covers whole blocks, so
+        // skip the points outside the original loops, and tell bounds
+        // inference that the inner and outer stay in bounds.
+        Expr inner_min = Variable::make(Int(32), prefix + split.inner + ".loop_min");
+        Expr inner_max = Variable::make(Int(32), prefix + split.inner + ".loop_max");
+        Expr inner_extent = Variable::make(Int(32), prefix + split.inner + ".loop_extent");
+        Expr outer_min = Variable::make(Int(32), prefix + split.outer + ".loop_min");
+        Expr outer_max = Variable::make(Int(32), prefix + split.outer + ".loop_max");
+        Expr outer_extent = Variable::make(Int(32), prefix + split.outer + ".loop_extent");
+
+        Expr inner_offset = Variable::make(Int(32), prefix + split.old_var + ".curve_inner");
+        Expr outer_offset = Variable::make(Int(32), prefix + split.old_var + ".curve_outer");
+        Expr inner = promise_clamped(inner_offset + inner_min, inner_min, inner_max);
+        Expr outer = promise_clamped(outer_offset + outer_min, outer_min, outer_max);
+
+        result.emplace_back(prefix + split.inner, inner, ApplySplitResult::Substitution);
+        result.emplace_back(prefix + split.outer, outer, ApplySplitResult::Substitution);
+        result.emplace_back(prefix + split.inner, inner, ApplySplitResult::LetStmt);
+        result.emplace_back(prefix + split.outer, outer, ApplySplitResult::LetStmt);
+        result.emplace_back(inner_offset < inner_extent && outer_offset < outer_extent);
+
+        vector<ApplySplitResult> offsets = curve_offsets(split, prefix);
+        result.insert(result.end(), offsets.begin(), offsets.end());
     } else if (split.is_fuse()) {
         // Define the inner and outer in terms of the fused var
         Expr fused = Variable::make(Int(32), prefix + split.old_var);
@@ -141,6 +260,31 @@ vector<std::pair<string, Expr>> compute_loop_bounds_after_split(const Split &spl
         let_stmts.emplace_back(prefix + split.outer + ".loop_min", 0);
         let_stmts.emplace_back(prefix + split.outer + ".loop_max", outer_extent - 1);
         let_stmts.emplace_back(prefix + split.outer + ".loop_extent", outer_extent);
+    } else if (split.is_fuse() && split.order != TileOrder::RowMajor) {
+        // The fused var covers a run of square blocks of side 2^bits
+        // along the longer dimension, where 2^bits is at least the
+        // shorter extent. Rounding both extents up this way can make
+        // the fused loop nearly 4x as long as the two loops it
+        // replaces; the extra iterations are skipped. If the shorter
+        // extent needs more than max_curve_bits, or the padded extent
+        // doesn't fit in an Int(32), the loops are fused in row-major
+        // order instead.
+        Expr inner_extent = Variable::make(Int(32), prefix + split.inner + ".loop_extent");
+        Expr outer_extent = Variable::make(Int(32), prefix + split.outer + ".loop_extent");
+        Expr bits = Variable::make(Int(32), prefix + split.old_var + ".curve_bits");
+        Expr fits = Variable::make(Bool(), prefix + split.old_var + ".curve_fits");
+        Expr short_extent = max(min(inner_extent, outer_extent), 1);
+        Expr long_extent = cast<int64_t>(max(inner_extent, outer_extent));
+        Expr needed_bits = 32 - count_leading_zeros(short_extent - 1);
+        Expr blocks = (long_extent + (make_const(Int(64), 1) << bits) - 1) >> bits;
+        Expr curve_extent = blocks << (bits * 2);
+        Expr fused_extent = select(fits, cast<int32_t>(curve_extent), inner_extent * outer_extent);
+        let_stmts.emplace_back(prefix + split.old_var + ".loop_min", 0);
+        let_stmts.emplace_back(prefix + split.old_var + ".loop_max", fused_extent - 1);
+        let_stmts.emplace_back(prefix + split.old_var + ".loop_extent", fused_extent);
+        let_stmts.emplace_back(prefix + split.old_var + ".curve_fits",
+                               needed_bits <= max_curve_bits && curve_extent <= make_const(Int(64), 0x7fffffff));
+        let_stmts.emplace_back(prefix + split.old_var + ".curve_bits", min(needed_bits, max_curve_bits));
     } else if (split.is_fuse()) {
         // Define bounds on the fused var using the bounds on the inner and outer
         Expr inner_extent = Variable::make(Int(32), prefix + split.inner + ".loop_extent");
@@ -159,5 +303,76 @@ vector<std::pair<string, Expr>> compute_loop_bounds_after_split(const Split &spl
     return let_stmts;
 }
 
+namespace {
+
+// Fuse x (inner) and y (outer) into t along a Morton curve, with
+// constant extents, and check the extent of t and whether the curve
+// was used. If point is non-negative, also check the offsets of x and y
+// at t == point.
+void check_curve_fuse(int inner_extent, int outer_extent, int64_t expected_extent, bool expected_fits,
+                      int point = -1, int expected_x = 0, int expected_y = 0) {
+    Split split = {"t", "y", "x", Expr(), false, TailStrategy::Auto, Split::FuseVars, TileOrder::Morton};
+    map<string, Expr> dim_extent_alignment;
+    vector<ApplySplitResult> offsets = apply_split(split, false, "", dim_extent_alignment);
+    vector<std::pair<string, Expr>> bounds = compute_loop_bounds_after_split(split, "");
+
+    // Fold the lets, outermost first.
+    map<string, Expr> values;
+    values["x.loop_min"] = 0;
+    values["y.loop_min"] = 0;
+    values["x.loop_extent"] = inner_extent;
+    values["y.loop_extent"] = outer_extent;
+    values["x.loop_max"] = inner_extent - 1;
+    values["y.loop_max"] = outer_extent - 1;
+    for (auto it = bounds.rbegin(); it != bounds.rend(); it++) {
+        values[it->first] = simplify(substitute(values, it->second));
+    }
+    Expr extent = values["t.loop_extent"];
+    Expr fits = values["t.curve_fits"];
+    if (!is_const(extent, expected_extent) || !is_const(fits, expected_fits)) {
+        internal_error << "Fusing " << inner_extent << " x " << outer_extent
+                       << " along a Morton curve gave extent " << extent
+                       << " and curve_fits " << fits << " instead of "
+                       << expected_extent << " and " << expected_fits << "\n";
+    }
+
+    if (point < 0) {
+        return;
+    }
+    values["t"] = point;
+    for (auto it = offsets.rbegin(); it != offsets.rend(); it++) {
+        if (it->is_let()) {
+            values[it->name] = simplify(substitute(values, it->value));
+        }
+    }
+    Expr x = values["t.curve_inner"], y = values["t.curve_outer"];
+    if (!is_const(x, expected_x) || !is_const(y, expected_y)) {
+        internal_error << "Point " << point << " of a Morton fuse of " << inner_extent << " x " << outer_extent
+                       << " is (" << x << ", " << y << ") instead of ("
+                       << expected_x << ", " << expected_y << ")\n";
+    }
+}
+
+}  // namespace
+
+void apply_split_test() {
+    // Non-power-of-two extents are padded to whole blocks
+    check_curve_fuse(100, 37, 128 * 64, true, 3, 1, 1);
+    check_curve_fuse(3, 3, 16, true, 2, 0, 1);
+    check_curve_fuse(65, 64, 2 * 64 * 64, true, 64 * 64, 64, 0);
+    check_curve_fuse(1, 50, 50, true, 7, 0, 7);
+
+    // At the largest supported block
+    check_curve_fuse(1 << 15, 1 << 15, (int64_t)1 << 30, true);
+    check_curve_fuse(1 << 15, (1 << 15) + 1, (int64_t)(1 << 15) * ((1 << 15) + 1), false);
+    // Too large for a block, so fused in row-major order
+    check_curve_fuse((1 << 15) + 1, (1 << 15) + 1, (int64_t)((1 << 15) + 1) * ((1 << 15) + 1), false,
+                     (1 << 15) + 3, 2, 1);
+    // The padded extent overflows, so fused in row-major order
+    check_curve_fuse(70000, 20000, (int64_t)70000 * 20000, false, 70001, 1, 1);
+
+    std::cout << "apply_split test passed\n";
+}
+
 }  // namespace Internal
 }  // namespace Halide
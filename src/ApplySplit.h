@@ -64,6 +64,8 @@ std::vector<ApplySplitResult> apply_split(
 std::vector<std::pair<std::string, Expr>> compute_loop_bounds_after_split(
     const Split &split, const std::string &prefix);
 
+void apply_split_test();
+
 }  // namespace Internal
 }  // namespace Halide
 
@@ -1,4 +1,6 @@
 #include <algorithm>
+#include <memory>
+#include <mutex>
 #include <regex>
 #include <utility>
 
@@ -14,6 +16,7 @@
 #include "RegionCosts.h"
 #include "Scope.h"
 #include "Simplify.h"
+#include "ThreadPool.h"
 #include "Util.h"
 
 namespace Halide {
@@ -196,12 +199,15 @@ struct DependenceAnalysis {
         }
     };
     // Cache for bounds queries (bound queries with the same parameters are
-    // common during the grouping process).
+    // common during the grouping process). Grouping choices are evaluated
+    // concurrently, so the cache is guarded by a mutex.
     map<RegionsRequiredQuery, vector<RegionsRequired>> regions_required_cache;
+    std::unique_ptr<std::mutex> regions_required_mutex;
 
     DependenceAnalysis(const map<string, Function> &env, const vector<string> &order,
                        const FuncValueBounds &func_val_bounds)
-        : env(env), order(order), func_val_bounds(func_val_bounds) {
+        : env(env), order(order), func_val_bounds(func_val_bounds),
+          regions_required_mutex(new std::mutex) {
     }
 
     // Return the regions of the producers ('prods') required to compute the region
@@ -394,13 +400,16 @@ DependenceAnalysis::regions_required(const Function &f, int stage_num,
 
     // Check the cache if we've already computed this previously.
     RegionsRequiredQuery query(f.name(), stage_num, prods, only_regions_computed);
-    const auto &iter = regions_required_cache.find(query);
-    if (iter != regions_required_cache.end()) {
-        const auto &it = std::find_if(iter->second.begin(), iter->second.end(),
-                                      [&bounds](const RegionsRequired &r) { return (r.bounds == bounds); });
-        if (it != iter->second.end()) {
-            internal_assert((iter->first == query) && (it->bounds == bounds));
-            return it->regions;
+    {
+        std::lock_guard<std::mutex> lock(*regions_required_mutex);
+        const auto &iter = regions_required_cache.find(query);
+        if (iter != regions_required_cache.end()) {
+            const auto &it = std::find_if(iter->second.begin(), iter->second.end(),
+                                          [&bounds](const RegionsRequired &r) { return (r.bounds == bounds); });
+            if (it != iter->second.end()) {
+                internal_assert((iter->first == query) && (it->bounds == bounds));
+                return it->regions;
+            }
         }
     }
 
@@ -582,6 +591,7 @@ DependenceAnalysis::regions_required(const Function &f, int stage_num,
         concrete_regions[f_reg.first] = concrete_box;
     }
 
+    std::lock_guard<std::mutex> lock(*regions_required_mutex);
     regions_required_cache[query].push_back(RegionsRequired(bounds, concrete_regions));
     return concrete_regions;
 }
@@ -1036,6 +1046,23 @@ struct Partitioner {
     // re-evaluated and caching them improves performance significantly.
     map<GroupingChoice, GroupConfig> grouping_cache;
 
+    // Cache for the analysis of a group with particular tile sizes. The
+    // analysis only depends on the group's output, members, inlined functions,
+    // and tile sizes, which are all part of the key, so entries stay valid as
+    // the grouping changes. Grouping choices are evaluated concurrently, so
+    // the cache is guarded by a mutex. The analysis itself also takes
+    // DependenceAnalysis::regions_required_mutex and RegionCosts::cache_mutex,
+    // which guard the bounds and StageCostKey caches. Each of these mutexes
+    // is only held around a lookup in or insertion into its own cache and
+    // never while taking another, so there is no lock order to respect.
+    map<string, GroupAnalysis> group_analysis_cache;
+    std::mutex group_analysis_mutex;
+
+    // The threads that grouping choices and tile configurations are
+    // evaluated on, shared by all of the grouping passes. Null if there
+    // is only one processor.
+    std::unique_ptr<ThreadPool<void>> thread_pool;
+
     // Each group in the pipeline has a single output stage. A group is comprised
     // of function stages that are computed together in tiles (stages of a function
     // are always grouped together). 'groups' is the mapping from the output stage
@@ -1090,8 +1117,16 @@ struct Partitioner {
 
     // Given a grouping 'g', compute the estimated cost (arithmetic + memory) and
     // parallelism that can be potentially exploited when computing that group.
+    // The result is memoized in 'group_analysis_cache'.
     GroupAnalysis analyze_group(const Group &g, bool show_analysis);
 
+    // Same as analyze_group, but always recomputes the analysis.
+    GroupAnalysis compute_group_analysis(const Group &g, bool show_analysis);
+
+    // Return the cost of a load relative to an arithmetic operation, given
+    // the memory footprint of the tile it is in.
+    Expr load_cost_factor(const Expr &footprint) const;
+
     // For each group in the partition, return the regions of the producers
     // need to be allocated to compute a tile of the group's output.
     map<FStage, map<string, Box>> group_storage_bounds();
@@ -1108,6 +1143,10 @@ struct Partitioner {
     // the highest estimated benefits.
     GroupConfig evaluate_choice(const GroupingChoice &group, Partitioner::Level level);
 
+    // Evaluate the grouping choices that are not in 'grouping_cache' yet
+    // concurrently, and add them to the cache.
+    void evaluate_choices(const vector<GroupingChoice> &choices, Partitioner::Level level);
+
     // Pick the best choice among all the grouping options currently available. Uses
     // the cost model to estimate the benefit of each choice. This returns a vector of
     // choice and configuration pairs which describe the best grouping choice.
@@ -1317,6 +1356,11 @@ Partitioner::Partitioner(const map<string, Box> &_pipeline_bounds,
                          RegionCosts &_costs)
     : pipeline_bounds(_pipeline_bounds), arch_params(_arch_params),
       dep_analysis(_dep_analysis), costs(_costs), outputs(_outputs) {
+    size_t num_threads = ThreadPool<void>::num_processors_online();
+    if (num_threads > 1) {
+        thread_pool.reset(new ThreadPool<void>(num_threads));
+    }
+
     // Place each stage of a function in its own group. Each stage is
     // a node in the pipeline graph.
     for (const auto &f : dep_analysis.env) {
@@ -1368,11 +1412,42 @@ Partitioner::Partitioner(const map<string, Box> &_pipeline_bounds,
     }
 }
 
+// Return f applied to each of 'items', evaluated on 'thread_pool' if
+// there is one, and serially otherwise.
+template<typename T, typename Item, typename F>
+vector<T> parallel_map(ThreadPool<void> *thread_pool, const vector<Item> &items, F f) {
+    vector<T> results(items.size());
+    if (!thread_pool || items.size() <= 1) {
+        for (size_t i = 0; i < items.size(); i++) {
+            results[i] = f(items[i]);
+        }
+        return results;
+    }
+
+    vector<std::future<void>> futures;
+    futures.reserve(items.size());
+    for (size_t i = 0; i < items.size(); i++) {
+        futures.push_back(thread_pool->async([&f, &items, &results, i]() { results[i] = f(items[i]); }));
+    }
+    for (auto &future : futures) {
+        future.get();
+    }
+    return results;
+}
+
 void Partitioner::initialize_groups() {
+    vector<Group *> initial_groups;
     for (pair<const FStage, Group> &g : groups) {
-        pair<map<string, Expr>, GroupAnalysis> best = find_best_tile_config(g.second);
-        g.second.tile_sizes = best.first;
-        group_costs.emplace(g.second.output, best.second);
+        initial_groups.push_back(&g.second);
+    }
+
+    typedef pair<map<string, Expr>, GroupAnalysis> TileConfig;
+    vector<TileConfig> best = parallel_map<TileConfig>(
+        thread_pool.get(), initial_groups, [this](Group *g) { return find_best_tile_config(*g); });
+
+    for (size_t i = 0; i < initial_groups.size(); i++) {
+        initial_groups[i]->tile_sizes = best[i].first;
+        group_costs.emplace(initial_groups[i]->output, best[i].second);
     }
     grouping_cache.clear();
 }
@@ -1424,6 +1499,22 @@ map<string, Expr> Partitioner::evaluate_reuse(const FStage &stg,
 vector<pair<Partitioner::GroupingChoice, Partitioner::GroupConfig>>
 Partitioner::choose_candidate_grouping(const vector<pair<string, string>> &cands,
                                        Partitioner::Level level) {
+    // Evaluate all the choices that have not been evaluated for grouping
+    // before up front, since they are independent of each other.
+    vector<GroupingChoice> new_choices;
+    for (const auto &p : cands) {
+        const Function &prod_f = get_element(dep_analysis.env, p.first);
+        FStage prod(prod_f, prod_f.updates().size());
+        for (const FStage &c : get_element(children, prod)) {
+            GroupingChoice cand_choice(prod_f.name(), c);
+            if (grouping_cache.find(cand_choice) == grouping_cache.end() &&
+                std::find(new_choices.begin(), new_choices.end(), cand_choice) == new_choices.end()) {
+                new_choices.push_back(cand_choice);
+            }
+        }
+    }
+    evaluate_choices(new_choices, level);
+
     vector<pair<GroupingChoice, GroupConfig>> best_grouping;
     Expr best_benefit = make_zero(Int(64));
     for (const auto &p : cands) {
@@ -1436,20 +1527,8 @@ Partitioner::choose_candidate_grouping(const vector<pair<string, string>> &cands
         FStage prod(prod_f, final_stage);
 
         for (const FStage &c : get_element(children, prod)) {
-            GroupConfig best_config;
             GroupingChoice cand_choice(prod_f.name(), c);
-
-            // Check if the candidate has been evaluated for grouping before
-            const auto &iter = grouping_cache.find(cand_choice);
-            if (iter != grouping_cache.end()) {
-                best_config = iter->second;
-            } else {
-                best_config = evaluate_choice(cand_choice, level);
-                // Cache the result of the evaluation for the pair
-                grouping_cache.emplace(cand_choice, best_config);
-            }
-
-            grouping.emplace_back(cand_choice, best_config);
+            grouping.emplace_back(cand_choice, get_element(grouping_cache, cand_choice));
         }
 
         bool no_redundant_work = false;
@@ -1803,7 +1882,56 @@ DimBounds Partitioner::get_bounds_from_tile_sizes(const FStage &s,
     return bounds;
 }
 
+// Without a description of the cache hierarchy, the cost of a load rises
+// linearly from 1 to 'balance' as the footprint approaches the size of the
+// last level cache. With one, it rises piecewise linearly through each
+// level instead: loads from footprints that fit in L1 cost 1, from ones
+// that just fit in L2 cost the geometric mean of 1 and 'balance', and from
+// ones that spill out of the last level cache cost 'balance'. The last
+// level cache is shared by the cores of a NUMA node, so each tile only
+// gets its share of it.
+Expr Partitioner::load_cost_factor(const Expr &footprint) const {
+    const float balance = arch_params.balance;
+    if (arch_params.l1_cache_size == 0 || arch_params.l2_cache_size == 0) {
+        float load_slope = balance / arch_params.last_level_cache_size;
+        return cast<int64_t>(min(1 + footprint * load_slope, balance));
+    }
+
+    const float l1 = (float)arch_params.l1_cache_size;
+    const float l2 = std::max((float)arch_params.l2_cache_size, l1 + 1);
+    float llc = (float)arch_params.last_level_cache_size;
+    if (arch_params.cores_per_numa_node > 1) {
+        llc /= arch_params.cores_per_numa_node;
+    }
+    llc = std::max(llc, l2 + 1);
+    const float l2_cost = std::sqrt(balance);
+
+    Expr f = cast<float>(footprint);
+    Expr cost = (1.0f +
+                 clamp(f - l1, 0.0f, l2 - l1) * ((l2_cost - 1) / (l2 - l1)) +
+                 clamp(f - l2, 0.0f, llc - l2) * ((balance - l2_cost) / (llc - l2)));
+    return cast<int64_t>(cost);
+}
+
 Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_analysis) {
+    std::ostringstream key;
+    key << g;
+    if (!show_analysis) {
+        std::lock_guard<std::mutex> lock(group_analysis_mutex);
+        const auto &iter = group_analysis_cache.find(key.str());
+        if (iter != group_analysis_cache.end()) {
+            return iter->second;
+        }
+    }
+
+    GroupAnalysis analysis = compute_group_analysis(g, show_analysis);
+
+    std::lock_guard<std::mutex> lock(group_analysis_mutex);
+    group_analysis_cache.emplace(key.str(), analysis);
+    return analysis;
+}
+
+Partitioner::GroupAnalysis Partitioner::compute_group_analysis(const Group &g, bool show_analysis) {
     set<string> group_inputs;
     set<string> group_members;
 
@@ -1948,21 +2076,15 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
                                      tile_cost.second);
     }*/
 
-    // TODO: Use smooth step curve from Jon to better model cache behavior,
-    // where each step corresponds to different cache level.
-    //
-    // The current cost model drops off linearly. Larger memory footprint is
-    // penalized more than smaller memory footprint (since smaller one can fit
-    // more in the cache). The cost is clamped at 'balance', which is roughly at
-    // memory footprint equal to or larger than the last level cache size.
+    // Larger memory footprint is penalized more than smaller memory
+    // footprint (since smaller one can fit more in the cache). See
+    // load_cost_factor for the shape of the curve.
 
     // If 'model_reuse' is set, the cost model should take into account memory
     // reuse within the tile, e.g. matrix multiply reuses inputs multiple times.
     // TODO: Implement a better reuse model.
     bool model_reuse = false;
 
-    // Linear dropoff
-    float load_slope = arch_params.balance / arch_params.last_level_cache_size;
     for (const auto &f_load : group_load_costs) {
         internal_assert(g.inlined.find(f_load.first) == g.inlined.end())
             << "Intermediates of inlined pure fuction \"" << f_load.first
@@ -2004,8 +2126,7 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
             }
 
             if (model_reuse) {
-                Expr initial_factor =
-                    cast<int64_t>(min(1 + initial_footprint * load_slope, arch_params.balance));
+                Expr initial_factor = load_cost_factor(initial_footprint);
                 per_tile_cost.memory += initial_factor * footprint;
             } else {
                 footprint = initial_footprint;
@@ -2016,7 +2137,7 @@ Partitioner::GroupAnalysis Partitioner::analyze_group(const Group &g, bool show_
             }
         }
 
-        Expr cost_factor = cast<int64_t>(min(1 + footprint * load_slope, arch_params.balance));
+        Expr cost_factor = load_cost_factor(footprint);
         per_tile_cost.memory += cost_factor * f_load.second;
     }
 
@@ -2095,6 +2216,15 @@ void Partitioner::merge_groups(const GroupingChoice &choice, const GroupConfig &
     group_costs[child] = eval.analysis;
 }
 
+void Partitioner::evaluate_choices(const vector<GroupingChoice> &choices,
+                                   Partitioner::Level level) {
+    vector<GroupConfig> configs = parallel_map<GroupConfig>(
+        thread_pool.get(), choices, [this, level](const GroupingChoice &choice) { return evaluate_choice(choice, level); });
+    for (size_t i = 0; i < choices.size(); i++) {
+        grouping_cache.emplace(choices[i], configs[i]);
+    }
+}
+
 Partitioner::GroupConfig Partitioner::evaluate_choice(const GroupingChoice &choice,
                                                       Partitioner::Level level) {
     // Create a group that reflects the grouping choice and evaluate the cost
@@ -2409,7 +2539,11 @@ void Partitioner::vectorize_stage(const Group &g, Stage f_handle, int stage_num,
     // values produced by the function.
     int vec_len = 0;
     for (const auto &type : func.output_types()) {
-        vec_len = std::max(vec_len, t.natural_vector_size(type));
+        int lanes = t.natural_vector_size(type);
+        if (arch_params.vector_width > 0) {
+            lanes = std::max(1, arch_params.vector_width / type.bytes());
+        }
+        vec_len = std::max(vec_len, lanes);
     }
 
     for (int d = 0; d < (int)dims.size() - 1; d++) {
@@ -446,6 +446,60 @@ void CodeGen_X86::visit(const VectorReduce *op) {
     CodeGen_Posix::visit(op);
 }
 
+bool CodeGen_X86::should_use_gather(const Load *op) const {
+    // Gathers only exist for 32- and 64-bit elements. Emulating
+    // narrower gathers with wider ones could read past the end of
+    // the buffer, so leave those scalarized.
+    const Type &t = op->type;
+    if (!t.is_vector() ||
+        !target.has_feature(Target::AVX2) ||
+        (t.bits() != 32 && t.bits() != 64) ||
+        op->index.type().bits() != 32) {
+        return false;
+    }
+
+    // Ramps (even with non-constant stride) are handled without
+    // materializing the index vector, and broadcasts are better off
+    // as a scalar load.
+    if (op->index.as<Ramp>() || op->index.as<Broadcast>()) {
+        return false;
+    }
+
+    // On AVX2-only parts (Haswell/Broadwell) gather is microcoded
+    // and only beats scalar loads when it fills a whole ymm
+    // register. The AVX-512 parts have much faster gathers, so an
+    // xmm-sized gather is already a win there.
+    const bool fast_gather = (target.has_feature(Target::AVX512) ||
+                              target.has_feature(Target::AVX512_KNL) ||
+                              target.has_feature(Target::AVX512_Skylake) ||
+                              target.has_feature(Target::AVX512_Cannonlake));
+    const int min_bits = fast_gather ? 128 : 256;
+    return t.bits() * t.lanes() >= min_bits;
+}
+
+void CodeGen_X86::visit(const Load *op) {
+    if (!is_one(op->predicate) ||
+        upgrade_type_for_storage(op->type) != op->type ||
+        !should_use_gather(op)) {
+        CodeGen_Posix::visit(op);
+        return;
+    }
+
+    // Compute a vector of pointers from the (vector) index, and let
+    // llvm select vpgatherdd/vgatherdps and friends for the masked
+    // gather intrinsic.
+    Value *base = codegen_buffer_pointer(op->name, op->type.element_of(), ConstantInt::get(i32_t, 0));
+    Value *index = codegen(op->index);
+    Value *ptrs = builder->CreateInBoundsGEP(base, index);
+#if LLVM_VERSION >= 110
+    Instruction *gather = builder->CreateMaskedGather(ptrs, llvm::Align(op->type.bytes()));
+#else
+    Instruction *gather = builder->CreateMaskedGather(ptrs, op->type.bytes());
+#endif
+    add_tbaa_metadata(gather, op->name, op->index);
+    value = gather;
+}
+
 string CodeGen_X86::mcpu() const {
     if (target.has_feature(Target::AVX512_Cannonlake)) return "cannonlake";
     if (target.has_feature(Target::AVX512_Skylake)) return "skylake-avx512";
@@ -49,7 +49,13 @@ protected:
     void visit(const Select *) override;
     void visit(const VectorReduce *) override;
     void visit(const Mul *) override;
+    void visit(const Load *) override;
     // @}
+
+    /** Decide whether a vector load with a non-ramp index should be
+     * lowered to a hardware gather (vpgatherdd and friends) instead of
+     * a sequence of scalar loads and insertelements. */
+    bool should_use_gather(const Load *op) const;
 };
 
 }  // namespace Internal
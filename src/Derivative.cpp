@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include <set>
@@ -50,6 +51,10 @@ public:
         return adjoint_funcs;
     }
 
+    const map<string, Box> &get_func_bounds() const {
+        return func_bounds;
+    }
+
 protected:
     void visit(const IntImm *) override;
     void visit(const UIntImm *) override;
@@ -1917,6 +1922,179 @@ void ReverseAccumulationVisitor::propagate_halide_function_call(
     }
 }
 
+// Count the distinct IR nodes in some expressions, as a rough
+// measure of the cost of recomputing them.
+class CountNodes : public IRGraphVisitor {
+    using IRGraphVisitor::include;
+
+    std::set<const IRNode *> counted;
+
+    void include(const Expr &e) override {
+        if (counted.insert(e.get()).second) {
+            count++;
+        }
+        IRGraphVisitor::include(e);
+    }
+
+public:
+    int64_t count = 0;
+};
+
+// The size in bytes of a realization of a Func over the given
+// bounds, or -1 if the bounds aren't constant.
+int64_t realization_bytes(const Function &f, const Box &bounds) {
+    int64_t bytes = 0;
+    for (const Type &t : f.output_types()) {
+        bytes += t.bytes();
+    }
+    for (const Interval &i : bounds.bounds) {
+        const int64_t *extent = as_const_int(simplify(i.max - i.min + 1));
+        if (!extent) {
+            return -1;
+        }
+        bytes *= std::max(*extent, (int64_t)0);
+    }
+    return bytes;
+}
+
+// Make the derivatives recompute the forward Funcs that aren't
+// checkpoints. Each one gets a pure copy, which calls the copies of its
+// producers that are also recomputed, and the Funcs built for the
+// backward pass call the copies instead of the originals.
+void apply_checkpoints(const Func &output,
+                       const Func &adjoint,
+                       const GradientCheckpoints &checkpoints,
+                       const map<string, Box> &func_bounds,
+                       map<FuncKey, Func> &adjoint_funcs) {
+    if (checkpoints.funcs.empty() && checkpoints.memory_budget < 0) {
+        // Everything is stored
+        return;
+    }
+
+    map<string, Function> env = find_transitive_calls(output.function());
+    vector<string> order =
+        realization_order({output.function()}, env).first;
+
+    set<string> keep;
+    keep.insert(output.name());
+    for (const Func &f : checkpoints.funcs) {
+        user_assert(env.count(f.name()))
+            << "Checkpoint " << f.name() << " is not used to compute " << output.name() << "\n";
+        keep.insert(f.name());
+    }
+
+    // Only pure Funcs can be recomputed with a copy
+    vector<string> candidates;
+    for (const auto &name : order) {
+        const Function &f = env[name];
+        if (f.has_update_definition() || f.has_extern_definition()) {
+            keep.insert(name);
+        } else if (!keep.count(name)) {
+            candidates.push_back(name);
+        }
+    }
+
+    if (checkpoints.memory_budget >= 0) {
+        auto bytes_of = [&](const string &name) -> int64_t {
+            auto it = func_bounds.find(name);
+            if (it == func_bounds.end()) {
+                return -1;
+            }
+            return realization_bytes(env[name], it->second);
+        };
+
+        int64_t used = 0;
+        for (const auto &name : keep) {
+            used += std::max(bytes_of(name), (int64_t)0);
+        }
+
+        // Recomputing a Func also recomputes the producers that aren't
+        // stored, so the cost of a candidate includes the costs of the
+        // candidates it calls. The realization order puts producers first.
+        map<string, double> cost;
+        for (const auto &name : candidates) {
+            const Function &f = env[name];
+            CountNodes counter;
+            for (const Expr &e : f.values()) {
+                e.accept(&counter);
+            }
+            double c = (double)counter.count;
+            for (const auto &it : find_direct_calls(f)) {
+                auto producer = cost.find(it.first);
+                if (producer != cost.end()) {
+                    c += producer->second;
+                }
+            }
+            cost[name] = std::min(c, 1e30);
+        }
+
+        vector<pair<double, string>> by_cost_per_byte;
+        for (const auto &name : candidates) {
+            int64_t bytes = bytes_of(name);
+            if (bytes >= 0) {
+                by_cost_per_byte.emplace_back(cost[name] / std::max(bytes, (int64_t)1), name);
+            }
+        }
+        std::sort(by_cost_per_byte.begin(), by_cost_per_byte.end(),
+                  [](const pair<double, string> &a, const pair<double, string> &b) {
+                      return a.first > b.first;
+                  });
+        for (const auto &it : by_cost_per_byte) {
+            int64_t bytes = bytes_of(it.second);
+            if (used + bytes <= checkpoints.memory_budget) {
+                keep.insert(it.second);
+                used += bytes;
+            }
+        }
+        if (used > checkpoints.memory_budget) {
+            debug(1) << "The checkpoints that can't be recomputed need an estimated "
+                     << used << " bytes, over the budget of "
+                     << checkpoints.memory_budget << " bytes\n";
+        }
+        debug(1) << "Storing " << keep.size() << " of " << order.size()
+                 << " Funcs for the backward pass, using an estimated "
+                 << used << " bytes\n";
+    }
+
+    map<FunctionPtr, FunctionPtr> substitutions;
+    vector<Function> copies;
+    for (const auto &name : candidates) {
+        if (keep.count(name)) {
+            continue;
+        }
+        Func f(env[name]);
+        Func copy(unique_name(name + "_recompute"));
+        copy(f.args()) = f.values();
+        substitutions[f.function().get_contents()] = copy.function().get_contents();
+        copies.push_back(copy.function());
+    }
+    if (substitutions.empty()) {
+        return;
+    }
+    for (Function &copy : copies) {
+        copy.substitute_calls(substitutions);
+    }
+
+    // Leave the forward pipeline and the given adjoint alone
+    set<string> done;
+    for (const auto &it : env) {
+        done.insert(it.first);
+    }
+    for (const auto &it : find_transitive_calls(adjoint.function())) {
+        done.insert(it.first);
+    }
+    for (Function &copy : copies) {
+        done.insert(copy.name());
+    }
+    for (auto &it : adjoint_funcs) {
+        for (auto &backward : find_transitive_calls(it.second.function())) {
+            if (done.insert(backward.first).second) {
+                backward.second.substitute_calls(substitutions);
+            }
+        }
+    }
+}
+
 }  // namespace
 }  // namespace Internal
 
@@ -1950,6 +2128,22 @@ Func Derivative::operator()(const Param<> &param) const {
 Derivative propagate_adjoints(const Func &output,
                               const Func &adjoint,
                               const Region &output_bounds) {
+    return propagate_adjoints(output, adjoint, output_bounds, GradientCheckpoints());
+}
+
+Derivative propagate_adjoints(const Func &output,
+                              const Buffer<float> &adjoint) {
+    return propagate_adjoints(output, adjoint, GradientCheckpoints());
+}
+
+Derivative propagate_adjoints(const Func &output) {
+    return propagate_adjoints(output, GradientCheckpoints());
+}
+
+Derivative propagate_adjoints(const Func &output,
+                              const Func &adjoint,
+                              const Region &output_bounds,
+                              const GradientCheckpoints &checkpoints) {
     user_assert(output.dimensions() == adjoint.dimensions())
         << "output dimensions and adjoint dimensions must match\n";
     user_assert((int)output_bounds.size() == adjoint.dimensions())
@@ -1957,23 +2151,26 @@ Derivative propagate_adjoints(const Func &output,
 
     Internal::ReverseAccumulationVisitor visitor;
     visitor.propagate_adjoints(output, adjoint, output_bounds);
-    // Since the return value of get_adjoint_funcs() is a temporary,
-    // we should *not* use std::move.
-    return Derivative{visitor.get_adjoint_funcs()};
+    map<FuncKey, Func> adjoint_funcs = visitor.get_adjoint_funcs();
+    Internal::apply_checkpoints(output, adjoint, checkpoints,
+                                visitor.get_func_bounds(), adjoint_funcs);
+    return Derivative{std::move(adjoint_funcs)};
 }
 
 Derivative propagate_adjoints(const Func &output,
-                              const Buffer<float> &adjoint) {
+                              const Buffer<float> &adjoint,
+                              const GradientCheckpoints &checkpoints) {
     user_assert(output.dimensions() == adjoint.dimensions());
     Region bounds;
     for (int dim = 0; dim < adjoint.dimensions(); dim++) {
         bounds.emplace_back(adjoint.min(dim), adjoint.min(dim) + adjoint.extent(dim) - 1);
     }
     Func adjoint_func = BoundaryConditions::constant_exterior(adjoint, 0.f);
-    return propagate_adjoints(output, adjoint_func, bounds);
+    return propagate_adjoints(output, adjoint_func, bounds, checkpoints);
 }
 
-Derivative propagate_adjoints(const Func &output) {
+Derivative propagate_adjoints(const Func &output,
+                              const GradientCheckpoints &checkpoints) {
     Func adjoint("adjoint");
     adjoint(output.args()) = Internal::make_one(output.value().type());
     Region output_bounds;
@@ -1981,7 +2178,7 @@ Derivative propagate_adjoints(const Func &output) {
     for (int i = 0; i < output.dimensions(); i++) {
         output_bounds.push_back({0, 0});
     }
-    return propagate_adjoints(output, adjoint, output_bounds);
+    return propagate_adjoints(output, adjoint, output_bounds, checkpoints);
 }
 
 }  // namespace Halide
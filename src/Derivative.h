@@ -41,6 +41,29 @@ private:
     const std::map<FuncKey, Func> adjoints;
 };
 
+/**
+ *  Which forward Funcs the derivative Funcs read back from their stored
+ *  realizations (the checkpoints), and which they recompute instead.
+ *  Recomputing a Func means the derivatives call a pure copy of it,
+ *  named with a "_recompute" suffix, which is inlined by default, so the
+ *  forward realization doesn't need to stay alive for the backward pass.
+ *  This trades compute for memory.
+ *
+ *  By default every forward Func is a checkpoint. The output, and Funcs
+ *  with update or extern definitions, are always checkpoints.
+ */
+struct GradientCheckpoints {
+    /** Forward Funcs to store. If non-empty, the other pure Funcs
+     *  are recomputed. */
+    std::vector<Func> funcs;
+
+    /** If non-negative, also choose checkpoints automatically, keeping
+     *  the Funcs that are most expensive to recompute for their size
+     *  while the estimated size of all checkpoints stays within this
+     *  many bytes. Funcs whose bounds aren't constant are recomputed. */
+    int64_t memory_budget = -1;
+};
+
 /**
  *  Given a Func and a corresponding adjoint, (back)propagate the
  *  adjoint to all dependent Funcs, buffers, and parameters.
@@ -70,6 +93,22 @@ Derivative propagate_adjoints(const Func &output,
  */
 Derivative propagate_adjoints(const Func &output);
 
+/**
+ *  Variants of the above which store only the given checkpoints for
+ *  the backward pass, and recompute the other forward Funcs.
+ */
+// @{
+Derivative propagate_adjoints(const Func &output,
+                              const Func &adjoint,
+                              const Region &output_bounds,
+                              const GradientCheckpoints &checkpoints);
+Derivative propagate_adjoints(const Func &output,
+                              const Buffer<float> &adjoint,
+                              const GradientCheckpoints &checkpoints);
+Derivative propagate_adjoints(const Func &output,
+                              const GradientCheckpoints &checkpoints);
+// @}
+
 }  // namespace Halide
 
 #endif
@@ -1055,7 +1055,7 @@ void Stage::split(const string &old, const string &outer, const string &inner, c
     }
 
     // Add the split to the splits list
-    Split split = {old_name, outer_name, inner_name, factor, exact, tail, Split::SplitVar};
+    Split split = {old_name, outer_name, inner_name, factor, exact, tail, Split::SplitVar, TileOrder::RowMajor};
     definition.schedule().splits().push_back(split);
 }
 
@@ -1072,6 +1072,18 @@ Stage &Stage::split(const VarOrRVar &old, const VarOrRVar &outer, const VarOrRVa
 }
 
 Stage &Stage::fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRVar &fused) {
+    return fuse(inner, outer, fused, TileOrder::RowMajor);
+}
+
+Stage &Stage::fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRVar &fused, TileOrder order) {
+    if (order != TileOrder::RowMajor) {
+        user_assert(!fused.is_rvar && !outer.is_rvar && !inner.is_rvar)
+            << "In schedule for " << name() << ", can't fuse " << inner.name()
+            << " and " << outer.name() << " into " << fused.name()
+            << " along a space-filling curve, because only pure Vars may be"
+            << " traversed out of order.\n";
+    }
+
     if (!fused.is_rvar) {
         user_assert(!outer.is_rvar) << "Can't fuse Var " << fused.name()
                                     << " from RVar " << outer.name() << "\n";
@@ -1132,7 +1144,7 @@ Stage &Stage::fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRV
     }
 
     // Add the fuse to the splits list
-    Split split = {fused_name, outer_name, inner_name, Expr(), true, TailStrategy::RoundUp, Split::FuseVars};
+    Split split = {fused_name, outer_name, inner_name, Expr(), true, TailStrategy::RoundUp, Split::FuseVars, order};
     definition.schedule().splits().push_back(split);
     return *this;
 }
@@ -1226,7 +1238,7 @@ Stage &Stage::purify(const VarOrRVar &old_var, const VarOrRVar &new_var) {
             << dump_argument_list();
     }
 
-    Split split = {old_name, new_name, "", 1, false, TailStrategy::RoundUp, Split::PurifyRVar};
+    Split split = {old_name, new_name, "", 1, false, TailStrategy::RoundUp, Split::PurifyRVar, TileOrder::RowMajor};
     definition.schedule().splits().push_back(split);
     return *this;
 }
@@ -1408,7 +1420,7 @@ Stage &Stage::rename(const VarOrRVar &old_var, const VarOrRVar &new_var) {
     }
 
     if (!found) {
-        Split split = {old_name, new_name, "", 1, old_var.is_rvar, TailStrategy::RoundUp, Split::RenameVar};
+        Split split = {old_name, new_name, "", 1, old_var.is_rvar, TailStrategy::RoundUp, Split::RenameVar, TileOrder::RowMajor};
         definition.schedule().splits().push_back(split);
     }
 
@@ -1506,6 +1518,19 @@ Stage &Stage::tile(const VarOrRVar &x, const VarOrRVar &y,
     return *this;
 }
 
+Stage &Stage::tile(const VarOrRVar &x, const VarOrRVar &y,
+                   const VarOrRVar &tile,
+                   const VarOrRVar &xi, const VarOrRVar &yi,
+                   const Expr &xfactor, const Expr &yfactor,
+                   TileOrder order,
+                   TailStrategy tail) {
+    split(x, x, xi, xfactor, tail);
+    split(y, y, yi, yfactor, tail);
+    reorder(xi, yi, x, y);
+    fuse(x, y, tile, order);
+    return *this;
+}
+
 Stage &Stage::tile(const std::vector<VarOrRVar> &previous,
                    const std::vector<VarOrRVar> &outers,
                    const std::vector<VarOrRVar> &inners,
@@ -2038,6 +2063,12 @@ Func &Func::fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRVar
     return *this;
 }
 
+Func &Func::fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRVar &fused, TileOrder order) {
+    invalidate_cache();
+    Stage(func, func.definition(), 0).fuse(inner, outer, fused, order);
+    return *this;
+}
+
 Func &Func::rename(const VarOrRVar &old_name, const VarOrRVar &new_name) {
     invalidate_cache();
     Stage(func, func.definition(), 0).rename(old_name, new_name);
@@ -2250,6 +2281,17 @@ Func &Func::tile(const VarOrRVar &x, const VarOrRVar &y,
     return *this;
 }
 
+Func &Func::tile(const VarOrRVar &x, const VarOrRVar &y,
+                 const VarOrRVar &tile,
+                 const VarOrRVar &xi, const VarOrRVar &yi,
+                 const Expr &xfactor, const Expr &yfactor,
+                 TileOrder order,
+                 TailStrategy tail) {
+    invalidate_cache();
+    Stage(func, func.definition(), 0).tile(x, y, tile, xi, yi, xfactor, yfactor, order, tail);
+    return *this;
+}
+
 Func &Func::tile(const std::vector<VarOrRVar> &previous,
                  const std::vector<VarOrRVar> &outers,
                  const std::vector<VarOrRVar> &inners,
@@ -200,6 +200,10 @@ public:
      * the stage we are calling compute_with on should not have specializations,
      * e.g. f2.compute_with(f1, x) is allowed only if f2 has no specializations.
      *
+     * Compiling with Target::FuseSiblings applies compute_with automatically
+     * to compute_root Funcs without update definitions that read a common
+     * compute_root producer and have matching loop nests.
+     *
      * Also, if a producer is desired to be computed at the fused loop level,
      * the function passed to the compute_at() needs to be the "parent". Consider
      * the following code:
@@ -342,6 +346,7 @@ public:
 
     Stage &split(const VarOrRVar &old, const VarOrRVar &outer, const VarOrRVar &inner, const Expr &factor, TailStrategy tail = TailStrategy::Auto);
     Stage &fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRVar &fused);
+    Stage &fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRVar &fused, TileOrder order);
     Stage &serial(const VarOrRVar &var);
     Stage &parallel(const VarOrRVar &var);
     Stage &vectorize(const VarOrRVar &var);
@@ -357,6 +362,12 @@ public:
                 const VarOrRVar &xi, const VarOrRVar &yi,
                 const Expr &xfactor, const Expr &yfactor,
                 TailStrategy tail = TailStrategy::Auto);
+    Stage &tile(const VarOrRVar &x, const VarOrRVar &y,
+                const VarOrRVar &tile,
+                const VarOrRVar &xi, const VarOrRVar &yi,
+                const Expr &xfactor, const Expr &yfactor,
+                TileOrder order,
+                TailStrategy tail = TailStrategy::Auto);
     Stage &tile(const std::vector<VarOrRVar> &previous,
                 const std::vector<VarOrRVar> &outers,
                 const std::vector<VarOrRVar> &inners,
@@ -1470,6 +1481,14 @@ public:
      * outer dimensions given. */
     Func &fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRVar &fused);
 
+    /** Join two dimensions into a single fused dimension that visits
+     * their values in the given order (see \ref TileOrder). Orders
+     * other than RowMajor walk a space-filling curve over square
+     * power-of-two blocks, and skip the points of the last blocks
+     * that fall outside the two dimensions, so the fused dimension
+     * may be somewhat longer than the product of their extents. */
+    Func &fuse(const VarOrRVar &inner, const VarOrRVar &outer, const VarOrRVar &fused, TileOrder order);
+
     /** Mark a dimension to be traversed serially. This is the default. */
     Func &serial(const VarOrRVar &var);
 
@@ -1574,6 +1593,24 @@ public:
                const Expr &xfactor, const Expr &yfactor,
                TailStrategy tail = TailStrategy::Auto);
 
+    /** Tile x and y as above, then fuse the loops over the tiles into
+     * a single dimension 'tile' that visits them in the given
+     * order. With TileOrder::Morton or TileOrder::Hilbert, pick a
+     * small tile that fits in the innermost cache, and the
+     * space-filling curve keeps groups of nearby tiles together for
+     * every larger cache, without tuning the tile size to each
+     * machine. E.g:
+     \code
+     f.tile(x, y, t, xi, yi, 16, 16, TileOrder::Morton).parallel(t);
+     \endcode
+     */
+    Func &tile(const VarOrRVar &x, const VarOrRVar &y,
+               const VarOrRVar &tile,
+               const VarOrRVar &xi, const VarOrRVar &yi,
+               const Expr &xfactor, const Expr &yfactor,
+               TileOrder order,
+               TailStrategy tail = TailStrategy::Auto);
+
     /** A more general form of tile, which defines tiles of any dimensionality. */
     Func &tile(const std::vector<VarOrRVar> &previous,
                const std::vector<VarOrRVar> &outers,
@@ -1655,6 +1692,19 @@ public:
      * will be compiled to updates guarded by a mutex lock,
      * since it is impossible to atomically update two different locations.
      *
+     * Vectorizing an atomic update whose store location is
+     * data-dependent, such as
+     *
+     * hist.update().atomic().vectorize(r, 8);
+     *
+     * gives each lane its own copy of the locations it could update,
+     * when the index has a small range of values (e.g. it is a uint8),
+     * and there is a serial loop around the vectorized one to amortize
+     * the copies over. The copies are reduced into the Func afterwards.
+     * Otherwise lanes that hit the same location are combined within
+     * the vector first, but each lane still does its own
+     * read-modify-write, which is atomic inside a parallel loop.
+     *
      * Currently the atomic operation is supported by x86, CUDA, and OpenCL backends.
      * Compiling to other backends results in a compile error.
      * If an operation is compiled into a mutex lock, and is vectorized or is
@@ -0,0 +1,301 @@
+#include <algorithm>
+#include <set>
+
+#include "Debug.h"
+#include "FindCalls.h"
+#include "Func.h"
+#include "Function.h"
+#include "FuseSiblings.h"
+#include "IREquality.h"
+#include "RealizationOrder.h"
+
+namespace Halide {
+namespace Internal {
+
+using std::map;
+using std::set;
+using std::string;
+using std::vector;
+
+namespace {
+
+// Can this loop be part of a fused loop nest?
+bool is_fusable_loop(const Dim &d) {
+    return ((d.for_type == ForType::Serial || d.for_type == ForType::Parallel) &&
+            (d.device_api == DeviceAPI::None || d.device_api == DeviceAPI::Host));
+}
+
+bool same_split(const Split &a, const Split &b) {
+    return (a.split_type == b.split_type &&
+            a.old_var == b.old_var &&
+            a.outer == b.outer &&
+            a.inner == b.inner &&
+            a.exact == b.exact &&
+            a.tail == b.tail &&
+            a.order == b.order &&
+            a.factor.defined() == b.factor.defined() &&
+            (!a.factor.defined() || equal(a.factor, b.factor)));
+}
+
+// The splits, fuses, and renames that produce any of the given loop
+// variables, in the order they were applied.
+vector<Split> splits_producing(const vector<Split> &splits, const vector<string> &vars) {
+    set<string> wanted(vars.begin(), vars.end());
+    vector<Split> result;
+    for (auto it = splits.rbegin(); it != splits.rend(); ++it) {
+        bool produces = (it->is_fuse() ?
+                             wanted.count(it->old_var) :
+                             (wanted.count(it->outer) || (it->is_split() && wanted.count(it->inner))));
+        if (produces) {
+            result.push_back(*it);
+            if (it->is_fuse()) {
+                wanted.insert(it->outer);
+                wanted.insert(it->inner);
+            } else {
+                wanted.insert(it->old_var);
+            }
+        }
+    }
+    std::reverse(result.begin(), result.end());
+    return result;
+}
+
+// Return the names of the loops, from the outermost in, that a and b
+// could share if b were computed with a. The loops must match exactly
+// in name, type, and the splits that produced them, and stop at the
+// first vectorized, unrolled, or device loop.
+vector<string> common_outer_loops(const Function &a, const Function &b) {
+    const StageSchedule &sched_a = a.definition().schedule();
+    const StageSchedule &sched_b = b.definition().schedule();
+    const vector<Dim> &dims_a = sched_a.dims();
+    const vector<Dim> &dims_b = sched_b.dims();
+
+    vector<string> loops;
+    // Skip __outermost, which is always the last dim.
+    for (size_t i = 1; i < std::min(dims_a.size(), dims_b.size()); i++) {
+        const Dim &da = dims_a[dims_a.size() - 1 - i];
+        const Dim &db = dims_b[dims_b.size() - 1 - i];
+        if (da.var != db.var ||
+            da.for_type != db.for_type ||
+            da.device_api != db.device_api ||
+            da.dim_type != db.dim_type ||
+            !is_fusable_loop(da)) {
+            break;
+        }
+        loops.push_back(da.var);
+    }
+
+    // Drop loops from the inside until the loops that remain are
+    // derived from the same splits in both Funcs.
+    while (!loops.empty()) {
+        vector<Split> splits_a = splits_producing(sched_a.splits(), loops);
+        vector<Split> splits_b = splits_producing(sched_b.splits(), loops);
+        if (splits_a.size() == splits_b.size() &&
+            std::equal(splits_a.begin(), splits_a.end(), splits_b.begin(), same_split)) {
+            break;
+        }
+        loops.pop_back();
+    }
+    return loops;
+}
+
+bool is_candidate(const Function &f, const set<string> &already_fused) {
+    if (f.has_extern_definition() ||
+        !f.updates().empty() ||
+        !f.definition().specializations().empty() ||
+        !f.schedule().compute_level().is_root() ||
+        !f.schedule().store_level().is_root() ||
+        f.schedule().memoized() ||
+        f.schedule().async() ||
+        already_fused.count(f.name())) {
+        return false;
+    }
+    return true;
+}
+
+// Would realizing each group of Funcs as a unit create a cycle? Each
+// Func is in its own group unless it appears in group_of.
+bool has_cycle(const map<string, set<string>> &direct_calls,
+               const map<string, int> &group_of) {
+    auto node = [&](const string &f) {
+        auto it = group_of.find(f);
+        return it == group_of.end() ? f : "_group" + std::to_string(it->second);
+    };
+    map<string, set<string>> graph;
+    for (const auto &iter : direct_calls) {
+        set<string> &callees = graph[node(iter.first)];
+        for (const string &callee : iter.second) {
+            callees.insert(node(callee));
+        }
+    }
+    for (auto &iter : graph) {
+        iter.second.erase(iter.first);
+    }
+
+    // Iterative depth-first search for a back edge.
+    map<string, int> state;  // 1 = on the stack, 2 = done
+    for (const auto &root : graph) {
+        if (state[root.first]) {
+            continue;
+        }
+        vector<std::pair<string, set<string>::const_iterator>> stack;
+        state[root.first] = 1;
+        stack.emplace_back(root.first, root.second.begin());
+        while (!stack.empty()) {
+            const set<string> &callees = graph[stack.back().first];
+            if (stack.back().second == callees.end()) {
+                state[stack.back().first] = 2;
+                stack.pop_back();
+                continue;
+            }
+            const string &next = *(stack.back().second++);
+            if (state[next] == 1) {
+                return true;
+            } else if (state[next] == 0) {
+                state[next] = 1;
+                stack.emplace_back(next, graph[next].begin());
+            }
+        }
+    }
+    return false;
+}
+
+struct SiblingGroup {
+    Function leader;
+    // The loop of the leader the other members are computed with, or
+    // empty if the leader has no siblings yet.
+    string fuse_var;
+    vector<string> members;
+};
+
+}  // anonymous namespace
+
+int fuse_sibling_loops(const vector<Function> &outputs, map<string, Function> &env) {
+    // Don't touch anything already involved in a compute_with.
+    set<string> already_fused;
+    for (const auto &iter : env) {
+        const Function &f = iter.second;
+        if (f.has_extern_definition()) {
+            continue;
+        }
+        for (size_t i = 0; i < f.updates().size() + 1; i++) {
+            const Definition &def = (i == 0) ? f.definition() : f.update(i - 1);
+            const LoopLevel &fuse_level = def.schedule().fuse_level().level;
+            if (!fuse_level.is_inlined() && !fuse_level.is_root()) {
+                already_fused.insert(f.name());
+                already_fused.insert(fuse_level.func());
+            }
+        }
+    }
+
+    map<string, map<string, Function>> indirect_calls;
+    for (const auto &iter : env) {
+        indirect_calls.emplace(iter.first, find_transitive_calls(iter.second));
+    }
+
+    map<string, set<string>> direct_calls;
+    for (const auto &iter : env) {
+        set<string> &callees = direct_calls[iter.first];
+        for (const auto &callee : find_direct_calls(iter.second)) {
+            callees.insert(callee.first);
+        }
+    }
+
+    auto depends_on = [&](const string &a, const string &b) {
+        const auto &calls = indirect_calls.at(a);
+        return calls.find(b) != calls.end();
+    };
+
+    // The compute_root Funcs called directly by a Func. These are the
+    // producers that fusing siblings lets us reuse from cache.
+    auto root_producers = [&](const Function &f) {
+        set<string> producers;
+        for (const string &callee : direct_calls.at(f.name())) {
+            if (callee != f.name() &&
+                env.count(callee) &&
+                env.at(callee).schedule().compute_level().is_root()) {
+                producers.insert(callee);
+            }
+        }
+        return producers;
+    };
+
+    vector<SiblingGroup> groups;
+    map<string, int> group_of;
+    int fused = 0;
+    for (const string &name : topological_order(outputs, env)) {
+        Function f = env.at(name);
+        if (!is_candidate(f, already_fused)) {
+            continue;
+        }
+        set<string> producers = root_producers(f);
+
+        bool placed = false;
+        for (size_t g = 0; g < groups.size(); g++) {
+            SiblingGroup &group = groups[g];
+            bool independent = true;
+            for (const string &m : group.members) {
+                if (depends_on(name, m) || depends_on(m, name)) {
+                    independent = false;
+                    break;
+                }
+            }
+            if (!independent) {
+                continue;
+            }
+
+            set<string> leader_producers = root_producers(group.leader);
+            bool shares_producer =
+                std::any_of(producers.begin(), producers.end(),
+                            [&](const string &p) { return leader_producers.count(p) > 0; });
+            if (!shares_producer) {
+                continue;
+            }
+
+            vector<string> loops = common_outer_loops(group.leader, f);
+            string fuse_var;
+            if (group.fuse_var.empty()) {
+                if (!loops.empty()) {
+                    fuse_var = loops.back();
+                }
+            } else if (std::find(loops.begin(), loops.end(), group.fuse_var) != loops.end()) {
+                fuse_var = group.fuse_var;
+            }
+            if (fuse_var.empty()) {
+                continue;
+            }
+
+            // Fused groups are realized as a unit, so make sure no
+            // other Func has to be computed both before and after
+            // this one.
+            group_of[name] = (int)g;
+            if (has_cycle(direct_calls, group_of)) {
+                group_of.erase(name);
+                continue;
+            }
+
+            debug(3) << "Computing " << name << " with its sibling "
+                     << group.leader.name() << " at loop " << fuse_var << "\n";
+            // Leave the alignment of every fused loop as Auto, so
+            // that sibling loops over different bounds still visit
+            // the same coordinates of the producer together.
+            f.definition().schedule().fuse_level() =
+                FuseLoopLevel(LoopLevel(group.leader, Var(fuse_var), 0).lock(), {});
+            group.fuse_var = fuse_var;
+            group.members.push_back(name);
+            fused++;
+            placed = true;
+            break;
+        }
+
+        if (!placed) {
+            group_of[name] = (int)groups.size();
+            groups.push_back({f, "", {name}});
+        }
+    }
+
+    return fused;
+}
+
+}  // namespace Internal
+}  // namespace Halide
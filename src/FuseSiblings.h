@@ -0,0 +1,36 @@
+#ifndef HALIDE_FUSE_SIBLINGS_H
+#define HALIDE_FUSE_SIBLINGS_H
+
+/** \file
+ * Defines a pass that automatically fuses the loop nests of sibling
+ * Funcs that read the same producer, as if they had been scheduled
+ * with compute_with.
+ */
+
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Halide {
+namespace Internal {
+
+class Function;
+
+/** Find groups of compute_root Funcs with identical loop nests that
+ * have no dependence on each other but read a common compute_root
+ * producer, and schedule each of them to be computed with the first
+ * member of its group at the innermost loop that is neither
+ * vectorized nor unrolled. The fused stages then consume the producer
+ * while it is still in cache, rather than each streaming it through
+ * memory separately. Funcs that have update definitions,
+ * specializations, an extern definition, or that are already involved
+ * in a compute_with are left alone. Must be called on the locked
+ * schedules, before the realization order is computed. Returns the
+ * number of Funcs that were fused with a sibling. */
+int fuse_sibling_loops(const std::vector<Function> &outputs,
+                       std::map<std::string, Function> &env);
+
+}  // namespace Internal
+}  // namespace Halide
+
+#endif
@@ -130,6 +130,9 @@ struct JITModule {
     /** See JITSharedRuntime::reuse_device_allocations */
     void reuse_device_allocations(bool) const;
 
+    /** See JITSharedRuntime::reuse_host_allocations */
+    void reuse_host_allocations(bool) const;
+
     /** Return true if compile_module has been called on this module. */
     bool compiled() const;
 };
@@ -174,6 +177,13 @@ public:
      * instead. */
     static void reuse_device_allocations(bool);
 
+    /** Set whether or not Halide may hold onto and reuse host
+     * allocations made by halide_malloc, to avoid calling malloc and
+     * free for allocations inside loops. If you are compiling
+     * statically, you should include HalideRuntime.h and call
+     * halide_reuse_host_allocations instead. */
+    static void reuse_host_allocations(bool);
+
     static void release_all();
 };
 
@@ -8,6 +8,7 @@
 #include "Substitute.h"
 
 #include <algorithm>
+#include <map>
 
 namespace Halide {
 namespace Internal {
@@ -181,6 +182,131 @@ Expr step_forwards(Expr e, const Scope<Expr> &linear) {
     }
 }
 
+/** Rewrite dense vector loads from the same buffer at constant
+ * offsets from each other (a sliding window) in terms of a set of
+ * non-overlapping vectors that tile the window, e.g. if the loop
+ * steps forwards by 8:
+ *
+ * f[ramp(x - 1, 1, 8)], f[ramp(x, 1, 8)], f[ramp(x + 1, 1, 8)]
+ *
+ * becomes slices of the concatenation of f[ramp(x - 7, 1, 8)] and
+ * f[ramp(x + 1, 1, 8)]. The tiling vectors are then exactly the
+ * previous iteration's tiling vectors shifted along by one, so they
+ * form a carry chain, and each loop iteration only loads the leading
+ * edge of the window. The slices become vpalignr/vext-style shuffles.
+ * Only loads whose base steps forwards by exactly one vector per loop
+ * iteration are considered.
+ *
+ * The tiles are placed so that the leading edge ends exactly where
+ * the window does. The trailing tile may then start before the
+ * window, but those lanes are never used, and on every iteration but
+ * the first they were in bounds on the previous iteration. For the
+ * first iteration, safe_initial_values maps the trailing tile to an
+ * equivalent in-bounds Expr. */
+Stmt tile_vector_windows(const Stmt &graph_stmt, const vector<vector<const Load *>> &loads,
+                         const Scope<Expr> &linear, int max_tiles,
+                         std::map<const Load *, Expr> &safe_initial_values) {
+    struct Window {
+        const Load *anchor;
+        // The distinct offsets from the anchor, and the loads at each.
+        vector<pair<int, vector<const Load *>>> members;
+    };
+    vector<Window> windows;
+
+    for (const vector<const Load *> &v : loads) {
+        const Load *load = v[0];
+        const Ramp *ramp = load->index.as<Ramp>();
+        const int lanes = load->type.lanes();
+        if (!ramp || !is_one(ramp->stride) || !is_one(load->predicate)) {
+            continue;
+        }
+        Expr step = is_linear(ramp->base, linear);
+        const int64_t *const_step = step.defined() ? as_const_int(simplify(step)) : nullptr;
+        if (!const_step || *const_step != lanes) {
+            continue;
+        }
+
+        bool placed = false;
+        for (Window &w : windows) {
+            if (w.anchor->name != load->name || w.anchor->type != load->type) {
+                continue;
+            }
+            Expr diff = simplify(ramp->base - w.anchor->index.as<Ramp>()->base);
+            const int64_t *offset = as_const_int(diff);
+            if (offset && Int(32).can_represent(*offset)) {
+                w.members.emplace_back((int)*offset, v);
+                placed = true;
+                break;
+            }
+        }
+        if (!placed) {
+            windows.push_back({load, {{0, v}}});
+        }
+    }
+
+    Stmt result = graph_stmt;
+    for (const Window &w : windows) {
+        if (w.members.size() < 2) {
+            continue;
+        }
+
+        const int lanes = w.anchor->type.lanes();
+        int min_offset = w.members[0].first, max_offset = w.members[0].first;
+        for (const auto &m : w.members) {
+            min_offset = std::min(min_offset, m.first);
+            max_offset = std::max(max_offset, m.first);
+        }
+        // The number of tiling vectors needed to cover the window.
+        const int num_tiles = (max_offset - min_offset + lanes - 1) / lanes + 1;
+        if (num_tiles > (int)w.members.size() + 1 || num_tiles > max_tiles) {
+            // The window is sparse (tiling it would add loads), or
+            // too large to carry.
+            continue;
+        }
+        const int first_offset = max_offset - (num_tiles - 1) * lanes;
+
+        const Expr &anchor_base = w.anchor->index.as<Ramp>()->base;
+        auto make_tile = [&](int offset) {
+            Expr base = simplify(anchor_base + offset);
+            return Load::make(w.anchor->type, w.anchor->name, Ramp::make(base, 1, lanes),
+                              w.anchor->image, w.anchor->param, const_true(lanes),
+                              w.anchor->alignment + offset);
+        };
+
+        vector<Expr> tiles;
+        for (int k = 0; k < num_tiles; k++) {
+            tiles.push_back(make_tile(first_offset + k * lanes));
+        }
+
+        if (first_offset < min_offset) {
+            // The first (min_offset - first_offset) lanes of the
+            // trailing tile are before the window and never used. The
+            // rest are the first lanes of the load at min_offset, so
+            // shift that in-bounds load up into place.
+            const int unused = min_offset - first_offset;
+            Expr in_bounds = make_tile(min_offset);
+            safe_initial_values[tiles[0].as<Load>()] =
+                Shuffle::make_slice(Shuffle::make_concat({in_bounds, in_bounds}), lanes - unused, 1, lanes);
+        }
+
+        for (const auto &m : w.members) {
+            int k = (m.first - first_offset) / lanes;
+            int shift = (m.first - first_offset) % lanes;
+            Expr replacement;
+            if (shift == 0) {
+                replacement = tiles[k];
+            } else {
+                replacement = Shuffle::make_slice(Shuffle::make_concat({tiles[k], tiles[k + 1]}),
+                                                  shift, 1, lanes);
+            }
+            for (const Load *l : m.second) {
+                result = graph_substitute(l, replacement, result);
+            }
+        }
+    }
+    return result;
+}
+
 /** Carry loads over a single For loop body. */
 class LoopCarryOverLoop : public IRMutator {
     // Track vars that step linearly with loop iterations
@@ -193,6 +319,8 @@ class LoopCarryOverLoop : public IRMutator {
 
     int max_carried_values;
 
+    bool carry_vector_windows;
+
     using IRMutator::visit;
 
     Stmt visit(const LetStmt *op) override {
@@ -244,21 +372,14 @@ class LoopCarryOverLoop : public IRMutator {
         return Block::make(result);
     }
 
-    Stmt lift_carried_values_out_of_stmt(const Stmt &orig_stmt) {
-        debug(4) << "About to lift carried values out of stmt: " << orig_stmt << "\n";
-
-        // The stmts, as graphs (lets subtituted in). We must only use
-        // graph-aware methods to touch these, lest we incur
-        // exponential runtime.
-        Stmt graph_stmt = substitute_in_all_lets(orig_stmt);
-
-        // Find all the loads in these stmts.
+    // Find all the loads in a stmt that are safe to lift out, and
+    // group the equal ones.
+    vector<vector<const Load *>> find_safe_loads(const Stmt &graph_stmt) {
         FindLoads find_loads;
         graph_stmt.accept(&find_loads);
 
         debug(4) << "Found " << find_loads.result.size() << " loads\n";
 
-        // Group equal loads
         vector<vector<const Load *>> loads;
         for (const Load *load : find_loads.result) {
             // Check if it's safe to lift out.
@@ -278,6 +399,29 @@ class LoopCarryOverLoop : public IRMutator {
                 loads.push_back({load});
             }
         }
+        return loads;
+    }
+
+    Stmt lift_carried_values_out_of_stmt(const Stmt &orig_stmt) {
+        debug(4) << "About to lift carried values out of stmt: " << orig_stmt << "\n";
+
+        // The stmts, as graphs (lets subtituted in). We must only use
+        // graph-aware methods to touch these, lest we incur
+        // exponential runtime.
+        Stmt graph_stmt = substitute_in_all_lets(orig_stmt);
+
+        vector<vector<const Load *>> loads = find_safe_loads(graph_stmt);
+
+        // Trailing window tiles that are only safe to load directly
+        // when they are carried from a previous iteration.
+        std::map<const Load *, Expr> safe_initial_values;
+        if (carry_vector_windows) {
+            Stmt tiled = tile_vector_windows(graph_stmt, loads, linear, max_carried_values, safe_initial_values);
+            if (!tiled.same_as(graph_stmt)) {
+                graph_stmt = tiled;
+                loads = find_safe_loads(graph_stmt);
+            }
+        }
 
         // For each load, move the load index forwards by one loop iteration
         vector<Expr> indices, next_indices, predicates, next_predicates;
@@ -309,6 +453,7 @@ class LoopCarryOverLoop : public IRMutator {
         }
 
         if (chains.empty()) {
+            // Nothing to carry. Any window tiling we did was pointless.
             return orig_stmt;
         }
 
@@ -370,6 +515,21 @@ class LoopCarryOverLoop : public IRMutator {
         }
         chains.swap(trimmed);
 
+        // Window tiles that didn't make it into a carry chain get
+        // loaded on every iteration, including the first, so must be
+        // in bounds.
+        for (const auto &p : safe_initial_values) {
+            bool carried = false;
+            for (const vector<int> &c : chains) {
+                for (size_t i = 0; i + 1 < c.size(); i++) {
+                    carried |= (loads[c[i]][0] == p.first);
+                }
+            }
+            if (!carried) {
+                graph_stmt = graph_substitute(p.first, p.second, graph_stmt);
+            }
+        }
+
         // We now have chains of the form:
         // f[x] <- f[x+1] <- ... <- f[x+N-1]
 
@@ -406,7 +566,12 @@ class LoopCarryOverLoop : public IRMutator {
                                                         Parameter(), const_true(orig_load->type.lanes()), ModulusRemainder());
                     not_first_iteration_scratch_stores.push_back(store_to_scratch);
                 } else {
-                    initial_scratch_values.emplace_back(orig_load);
+                    auto safe = safe_initial_values.find(orig_load);
+                    if (safe != safe_initial_values.end()) {
+                        initial_scratch_values.push_back(safe->second);
+                    } else {
+                        initial_scratch_values.emplace_back(orig_load);
+                    }
                 }
                 if (i > 0) {
                     Stmt shuffle = Store::make(scratch, load_from_scratch,
@@ -485,8 +650,8 @@ class LoopCarryOverLoop : public IRMutator {
     }
 
 public:
-    LoopCarryOverLoop(const string &var, const Scope<> &s, int max_carried_values)
-        : in_consume(s), max_carried_values(max_carried_values) {
+    LoopCarryOverLoop(const string &var, const Scope<> &s, int max_carried_values, bool carry_vector_windows)
+        : in_consume(s), max_carried_values(max_carried_values), carry_vector_windows(carry_vector_windows) {
         linear.push(var, 1);
     }
 
@@ -504,6 +669,7 @@ class LoopCarry : public IRMutator {
     using IRMutator::visit;
 
     int max_carried_values;
+    bool carry_vector_windows;
     Scope<> in_consume;
 
     Stmt visit(const ProducerConsumer *op) override {
@@ -517,10 +683,15 @@ class LoopCarry : public IRMutator {
     }
 
     Stmt visit(const For *op) override {
-        if (op->for_type == ForType::Serial && !is_one(op->extent)) {
+        if (carry_vector_windows &&
+            op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            // Leave device code alone.
+            return op;
+        } else if (op->for_type == ForType::Serial && !is_one(op->extent)) {
             Stmt stmt;
             Stmt body = mutate(op->body);
-            LoopCarryOverLoop carry(op->name, in_consume, max_carried_values);
+            LoopCarryOverLoop carry(op->name, in_consume, max_carried_values, carry_vector_windows);
             body = carry.mutate(body);
             if (body.same_as(op->body)) {
                 stmt = op;
@@ -543,15 +714,15 @@ class LoopCarry : public IRMutator {
     }
 
 public:
-    LoopCarry(int max_carried_values)
-        : max_carried_values(max_carried_values) {
+    LoopCarry(int max_carried_values, bool carry_vector_windows)
+        : max_carried_values(max_carried_values), carry_vector_windows(carry_vector_windows) {
     }
 };
 
 }  // namespace
 
-Stmt loop_carry(Stmt s, int max_carried_values) {
-    s = LoopCarry(max_carried_values).mutate(s);
+Stmt loop_carry(Stmt s, int max_carried_values, bool carry_vector_windows) {
+    s = LoopCarry(max_carried_values, carry_vector_windows).mutate(s);
     return s;
 }
 
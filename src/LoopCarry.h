@@ -10,9 +10,16 @@ namespace Internal {
  * induction variables instead of redoing the load. If the loads are
  * predicated, the predicates need to match. Can be an optimization or
  * pessimization depending on how good the L1 cache is on the architecture
- * and how many memory issue slots there are. Currently only intended
- * for Hexagon. */
-Stmt loop_carry(Stmt, int max_carried_values = 8);
+ * and how many memory issue slots there are. Used unconditionally
+ * for Hexagon, and for other targets with Target::LoopCarry.
+ *
+ * If carry_vector_windows is true, dense vector loads that form a
+ * sliding window over the loop (e.g. the taps of a 1D filter) are
+ * first rewritten as shuffles of non-overlapping vectors, so that
+ * whole vectors can be carried and only the leading edge of the
+ * window is loaded each iteration. On Hexagon the same effect comes
+ * from aligning the loads first (see AlignLoads.h). */
+Stmt loop_carry(Stmt, int max_carried_values = 8, bool carry_vector_windows = false);
 
 }  // namespace Internal
 }  // namespace Halide
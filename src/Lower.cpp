@@ -26,6 +26,7 @@
 #include "Func.h"
 #include "Function.h"
 #include "FuseGPUThreadLoops.h"
+#include "FuseSiblings.h"
 #include "FuzzFloatStores.h"
 #include "HexagonOffload.h"
 #include "IRMutator.h"
@@ -120,6 +121,12 @@ Module lower(const vector<Function> &output_funcs,
     // Substitute in wrapper Funcs
     env = wrap_func_calls(env);
 
+    if (t.has_feature(Target::FuseSiblings)) {
+        debug(1) << "Fusing the loops of sibling Funcs...\n";
+        int fused = fuse_sibling_loops(outputs, env);
+        debug(2) << "Fused " << fused << " Funcs with a sibling\n";
+    }
+
     // Compute a realization order and determine group of functions which loops
     // are to be fused together
     vector<string> order;
@@ -376,6 +383,15 @@ Module lower(const vector<Function> &output_funcs,
     debug(2) << "Lowering after hoisting loop invariant if statements:\n"
              << s << "\n\n";
 
+    if (t.has_feature(Target::LoopCarry) && t.arch != Target::Hexagon) {
+        // Hexagon always does this in its codegen, after aligning loads.
+        debug(1) << "Carrying values across loop iterations...\n";
+        s = loop_carry(s, 8, true);
+        s = simplify(s);
+        debug(2) << "Lowering after carrying values across loop iterations:\n"
+                 << s << "\n\n";
+    }
+
     debug(1) << "Injecting early frees...\n";
     s = inject_early_frees(s);
     debug(2) << "Lowering after injecting early frees:\n"
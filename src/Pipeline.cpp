@@ -1,5 +1,8 @@
 #include <algorithm>
 #include <atomic>
+#include <fstream>
+#include <set>
+#include <thread>
 #include <utility>
 
 #include "Argument.h"
@@ -116,6 +119,9 @@ struct PipelineContents {
 
     bool trace_pipeline;
 
+    // Where realize(sizes) allocates its outputs, if set.
+    std::shared_ptr<Runtime::BufferPool> output_buffer_pool;
+
     PipelineContents()
         : module("", Target()), trace_pipeline(false) {
         user_context_arg.arg = Argument("__user_context", Argument::InputScalar, type_of<const void *>(), 0, ArgumentEstimates{});
@@ -666,6 +672,11 @@ void Pipeline::set_custom_allocator(void *(*cust_malloc)(void *, size_t),
     contents->jit_handlers.custom_free = cust_free;
 }
 
+void Pipeline::set_output_buffer_pool(const std::shared_ptr<Runtime::BufferPool> &pool) {
+    user_assert(defined()) << "Pipeline is undefined\n";
+    contents->output_buffer_pool = pool;
+}
+
 void Pipeline::set_custom_do_par_for(int (*cust_do_par_for)(void *, int (*)(void *, int, uint8_t *), int, int, uint8_t *)) {
     user_assert(defined()) << "Pipeline is undefined\n";
     contents->jit_handlers.custom_do_par_for = cust_do_par_for;
@@ -736,7 +747,11 @@ Realization Pipeline::realize(vector<int32_t> sizes, const Target &target,
         realize(r, target, param_map);
     }
     for (size_t i = 0; i < r.size(); i++) {
-        r[i].allocate();
+        if (contents->output_buffer_pool) {
+            r[i].allocate(*contents->output_buffer_pool);
+        } else {
+            r[i].allocate();
+        }
     }
     // Do the actual computation
     realize(r, target, param_map);
@@ -1335,6 +1350,57 @@ JITExtern::JITExtern(const ExternCFunction &extern_c_function)
     : extern_c_function_(extern_c_function) {
 }
 
+namespace {
+
+#ifdef __linux__
+// Read the first line of a sysfs file, or return the empty string.
+std::string read_sysfs(const std::string &path) {
+    std::ifstream f(path);
+    std::string line;
+    std::getline(f, line);
+    return line;
+}
+
+// Parse a cache size like "32K" or "8M".
+uint64_t parse_cache_size(const std::string &s) {
+    uint64_t size = std::strtoull(s.c_str(), nullptr, 10);
+    if (s.find('K') != std::string::npos) {
+        size *= 1024;
+    } else if (s.find('M') != std::string::npos) {
+        size *= 1024 * 1024;
+    }
+    return size;
+}
+
+// Count the physical cores among the cpus in a list like "0-15,32-47".
+// Hyperthreads of the same core share its caches and execution units,
+// so they only count once. If the topology can't be read, each cpu
+// counts as a core.
+int count_cores(const std::string &s) {
+    std::set<std::pair<std::string, std::string>> cores;
+    int cpus = 0;
+    for (const std::string &range : split_string(s, ",")) {
+        std::vector<std::string> ends = split_string(range, "-");
+        if (ends.empty() || ends.size() > 2 || ends[0].empty()) {
+            continue;
+        }
+        const int first = std::atoi(ends[0].c_str());
+        const int last = std::atoi(ends.back().c_str());
+        for (int cpu = first; cpu <= last; cpu++) {
+            const std::string topology = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/topology/";
+            cores.emplace(read_sysfs(topology + "physical_package_id"), read_sysfs(topology + "core_id"));
+            cpus++;
+        }
+    }
+    if (cores.count({"", ""})) {
+        return cpus;
+    }
+    return (int)cores.size();
+}
+#endif
+
+}  // namespace
+
 MachineParams MachineParams::generic() {
     std::string params = Internal::get_env_variable("HL_MACHINE_PARAMS");
     if (params.empty()) {
@@ -1344,18 +1410,85 @@ MachineParams MachineParams::generic() {
     }
 }
 
+MachineParams MachineParams::host() {
+    MachineParams p(16, 16 * 1024 * 1024, 40);
+
+    int cores = (int)std::thread::hardware_concurrency();
+    if (cores > 0) {
+        p.parallelism = cores;
+    }
+
+#ifdef __linux__
+    cores = count_cores(read_sysfs("/sys/devices/system/cpu/online"));
+    if (cores > 0) {
+        p.parallelism = cores;
+    }
+    const std::string cpu0 = "/sys/devices/system/cpu/cpu0/cache/index";
+    int llc_level = 0;
+    for (int i = 0;; i++) {
+        const std::string dir = cpu0 + std::to_string(i) + "/";
+        const std::string level_str = read_sysfs(dir + "level");
+        if (level_str.empty()) {
+            break;
+        }
+        const int level = std::atoi(level_str.c_str());
+        const uint64_t size = parse_cache_size(read_sysfs(dir + "size"));
+        if (read_sysfs(dir + "type") == "Instruction" || size == 0) {
+            continue;
+        }
+        if (level == 1) {
+            p.l1_cache_size = size;
+        } else if (level == 2) {
+            p.l2_cache_size = size;
+        }
+        if (level >= llc_level) {
+            llc_level = level;
+            p.last_level_cache_size = size;
+        }
+    }
+    p.cores_per_numa_node = count_cores(read_sysfs("/sys/devices/system/node/node0/cpulist"));
+#endif
+
+    const Target t = get_host_target();
+    if (t.has_feature(Target::AVX512) ||
+        t.has_feature(Target::AVX512_Skylake) ||
+        t.has_feature(Target::AVX512_Cannonlake)) {
+        p.vector_width = 64;
+    } else if (t.has_feature(Target::AVX)) {
+        p.vector_width = 32;
+    } else if (t.arch == Target::X86 || t.arch == Target::ARM) {
+        p.vector_width = 16;
+    }
+
+    return p;
+}
+
 std::string MachineParams::to_string() const {
     std::ostringstream o;
     o << parallelism << "," << last_level_cache_size << "," << balance;
+    if (l1_cache_size || l2_cache_size || vector_width || cores_per_numa_node) {
+        o << "," << l1_cache_size << "," << l2_cache_size
+          << "," << vector_width << "," << cores_per_numa_node;
+    }
     return o.str();
 }
 
 MachineParams::MachineParams(const std::string &s) {
+    if (s == "host") {
+        *this = host();
+        return;
+    }
     std::vector<std::string> v = Internal::split_string(s, ",");
-    user_assert(v.size() == 3) << "Unable to parse MachineParams: " << s;
+    user_assert(v.size() == 3 || v.size() == 7) << "Unable to parse MachineParams: " << s;
     parallelism = std::atoi(v[0].c_str());
     last_level_cache_size = std::atoll(v[1].c_str());
     balance = std::atof(v[2].c_str());
+    if (v.size() == 7) {
+        l1_cache_size = std::atoll(v[3].c_str());
+        l2_cache_size = std::atoll(v[4].c_str());
+        vector_width = std::atoi(v[5].c_str());
+        cores_per_numa_node = std::atoi(v[6].c_str());
+    }
 }
 
 }  // namespace Halide
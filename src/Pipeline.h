@@ -8,6 +8,7 @@
  */
 
 #include <map>
+#include <memory>
 #include <vector>
 
 #include "ExternalCode.h"
@@ -36,18 +37,41 @@ struct MachineParams {
     /** Indicates how much more expensive is the cost of a load compared to
      * the cost of an arithmetic operation at last level cache. */
     float balance;
+    /** Sizes of the per-core first and second level data caches (in
+     * bytes), or zero if unknown. */
+    uint64_t l1_cache_size = 0, l2_cache_size = 0;
+    /** Width of the widest vector registers (in bytes), or zero to use
+     * the natural vector width of the target. */
+    int vector_width = 0;
+    /** Number of cores that share a NUMA node, and hence the last-level
+     * cache, or zero if unknown. */
+    int cores_per_numa_node = 0;
 
     explicit MachineParams(int parallelism, uint64_t llc, float balance)
         : parallelism(parallelism), last_level_cache_size(llc), balance(balance) {
     }
 
-    /** Default machine parameters for generic CPU architecture. */
+    /** Default machine parameters for generic CPU architecture. Set the
+     * HL_MACHINE_PARAMS environment variable to a canonical string, or
+     * to "host", to override them. */
     static MachineParams generic();
 
+    /** Machine parameters for the host, with the cache hierarchy read
+     * from sysfs on Linux, and the vector width taken from the host
+     * Target. The parallelism and cores per NUMA node count physical
+     * cores on Linux, so hyperthreads don't count twice. Elsewhere the
+     * parallelism is the number of logical CPUs. Anything that can't be
+     * detected takes its value from the generic parameters. */
+    static MachineParams host();
+
     /** Convert the MachineParams into canonical string form. */
     std::string to_string() const;
 
-    /** Reconstruct a MachineParams from canonical string form. */
+    /** Reconstruct a MachineParams from canonical string form. This is
+     * either "parallelism,last_level_cache_size,balance", or the same
+     * followed by
+     * ",l1_cache_size,l2_cache_size,vector_width,cores_per_numa_node".
+     * The string "host" is also accepted, meaning MachineParams::host(). */
     explicit MachineParams(const std::string &s);
 };
 
@@ -376,6 +400,15 @@ public:
     void set_custom_allocator(void *(*malloc)(void *, size_t),
                               void (*free)(void *, void *));
 
+    /** Allocate the outputs of realize(sizes) from a pool, so that
+     * the memory of a Realization that has been destroyed is reused
+     * by the next call to realize with the same output sizes instead
+     * of being freed and allocated again (e.g. when running a
+     * pipeline once per frame of a video). The pool may be shared
+     * with other Pipelines, and may be used from several threads at
+     * once. Pass nullptr to go back to allocating fresh outputs. */
+    void set_output_buffer_pool(const std::shared_ptr<Runtime::BufferPool> &pool);
+
     /** Set a custom task handler to be called by the parallel for
      * loop. It is useful to set this if you want to do some
      * additional bookkeeping at the granularity of parallel
@@ -503,6 +503,15 @@ Cost RegionCosts::region_cost(const map<string, Box> &regions, const set<string>
 map<string, Expr>
 RegionCosts::stage_detailed_load_costs(const string &func, int stage,
                                        const set<string> &inlines) {
+    StageCostKey key(func, stage, inlines);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        const auto &iter = stage_load_cost_cache.find(key);
+        if (iter != stage_load_cost_cache.end()) {
+            return iter->second;
+        }
+    }
+
     map<string, Expr> load_costs;
     Function curr_f = get_element(env, func);
 
@@ -529,6 +538,8 @@ RegionCosts::stage_detailed_load_costs(const string &func, int stage,
         }
     }
 
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    stage_load_cost_cache.emplace(key, load_costs);
     return load_costs;
 }
 
@@ -630,6 +641,15 @@ Cost RegionCosts::get_func_stage_cost(const Function &f, int stage,
         return Cost();
     }
 
+    StageCostKey key(f.name(), stage, inlines);
+    {
+        std::lock_guard<std::mutex> lock(cache_mutex);
+        const auto &iter = stage_cost_cache.find(key);
+        if (iter != stage_cost_cache.end()) {
+            return iter->second;
+        }
+    }
+
     Definition def = get_stage_definition(f, stage);
 
     Cost cost(0, 0);
@@ -661,6 +681,9 @@ Cost RegionCosts::get_func_stage_cost(const Function &f, int stage,
     }
 
     cost.simplify();
+
+    std::lock_guard<std::mutex> lock(cache_mutex);
+    stage_cost_cache.emplace(key, cost);
     return cost;
 }
 
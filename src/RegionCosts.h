@@ -8,7 +8,9 @@
  */
 
 #include <limits>
+#include <mutex>
 #include <set>
+#include <tuple>
 
 #include "AutoScheduleUtils.h"
 #include "Interval.h"
@@ -143,6 +145,18 @@ struct RegionCosts {
      * in the pipeline. The first function to be realized comes first. */
     RegionCosts(const std::map<std::string, Function> &env,
                 const std::vector<std::string> &order);
+
+private:
+    /** The per-value costs of a stage depend only on the stage and the set
+     * of functions inlined into it, but computing them means inlining and
+     * simplifying the stage's definition. The auto scheduler asks for the
+     * same ones many times over while grouping, so they are memoized here.
+     * The caches are guarded by 'cache_mutex', so that groups can be
+     * evaluated concurrently. */
+    typedef std::tuple<std::string, int, std::set<std::string>> StageCostKey;
+    mutable std::map<StageCostKey, Cost> stage_cost_cache;
+    mutable std::map<StageCostKey, std::map<std::string, Expr>> stage_load_cost_cache;
+    mutable std::mutex cache_mutex;
 };
 
 /** Return true if the cost of inlining a function is equivalent to the
@@ -72,6 +72,36 @@ enum class TailStrategy {
     Auto
 };
 
+/** Different orders in which the single loop produced by fusing two
+ * dimensions can visit the pairs of values of the original
+ * dimensions. */
+enum class TileOrder {
+    /** Visit every value of the inner dimension before moving on to the
+     * next value of the outer dimension. This is the default. */
+    RowMajor,
+
+    /** Visit the values along a Z-order (Morton) curve, within square
+     * power-of-two blocks laid end to end along the longer of the two
+     * dimensions. If the loops being fused are over tiles, this gives
+     * a recursively blocked traversal that has good locality at every
+     * level of the memory hierarchy without tuning the tile size to
+     * each cache. Only legal for pure variables.
+     *
+     * The blocks pad both dimensions up to a multiple of a power of
+     * two, so the fused loop can run for up to about 4x as many
+     * iterations as the loops it replaces. The extra iterations do
+     * nothing, but aren't free, so this suits loops over tiles rather
+     * than over individual values. If the shorter dimension is longer
+     * than 2^15, or the padded loop would have more than 2^31 - 1
+     * iterations, the values are visited in row-major order instead. */
+    Morton,
+
+    /** Like Morton, but along a Hilbert curve, so that consecutive
+     * values are always adjacent. Costs more index arithmetic per
+     * iteration of the fused loop than Morton. */
+    Hilbert
+};
+
 /** Different ways to handle the case when the start/end of the loops of stages
  * computed with (fused) are not aligned. */
 enum class LoopAlignStrategy {
@@ -272,6 +302,10 @@ struct Split {
     // split, it joins the outer and inner into the old_var.
     SplitType split_type;
 
+    // If split_type is Fuse, the order in which the old_var visits
+    // the values of the inner and outer. Ignored otherwise.
+    TileOrder order;
+
     bool is_rename() const {
         return split_type == RenameVar;
     }
@@ -349,6 +349,8 @@ const std::map<std::string, Target::Feature> feature_name_map = {
     {"sve", Target::SVE},
     {"sve2", Target::SVE2},
     {"arm_dot_prod", Target::ARMDotProd},
+    {"loop_carry", Target::LoopCarry},
+    {"fuse_siblings", Target::FuseSiblings},
     // NOTE: When adding features to this map, be sure to update PyEnums.cpp as well.
 };
 
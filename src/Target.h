@@ -124,6 +124,8 @@ struct Target {
         SVE = halide_target_feature_sve,
         SVE2 = halide_target_feature_sve2,
         ARMDotProd = halide_target_feature_arm_dot_prod,
+        LoopCarry = halide_target_feature_loop_carry,
+        FuseSiblings = halide_target_feature_fuse_siblings,
         FeatureEnd = halide_target_feature_end
     };
     Target()
@@ -1,6 +1,8 @@
 #include <algorithm>
+#include <set>
 #include <utility>
 
+#include "Bounds.h"
 #include "CSE.h"
 #include "CodeGen_GPU_Dev.h"
 #include "Deinterleave.h"
@@ -1032,6 +1034,124 @@ class VectorSubs : public IRMutator {
         return Allocate::make(op->name, op->type, op->memory_type, new_extents, op->condition, body, new_expr, op->free_function);
     }
 
+    // Vectorize an update of the form f[i] = f[i] <op> y, where the
+    // index i is a data-dependent vector that may contain repeated
+    // values (e.g. a histogram), and that PrivatizeScatteredUpdates
+    // couldn't give per-lane copies of f. Lanes that share an index are first
+    // combined in-register by comparing the index vector against
+    // each of its rotations (this is the work that AVX-512CD's
+    // vpconflictd does in a single instruction), so that the last
+    // lane with a given index holds the combined update for all of
+    // them. Every lane then does a read-modify-write, but the
+    // earlier duplicate lanes write back the value they read (or add
+    // zero), so they are harmless whether the store is scattered
+    // lane-by-lane in order or issued as per-lane atomics. Returns
+    // an undefined Stmt if the update doesn't have this form.
+    Stmt vectorize_scattered_update(const Atomic *op, const Store *store,
+                                    const Expr &a, const Expr &b,
+                                    VectorReduce::Operator reduce_op) {
+        const Load *load_a = a.as<Load>();
+        const Variable *store_var = store->index.as<Variable>();
+        const Variable *load_var = load_a ? load_a->index.as<Variable>() : nullptr;
+        const Variable *var_b = b.as<Variable>();
+
+        // The index must have been lifted out of the atomic node (so
+        // it doesn't depend on the buffer being updated), and must
+        // have become a vector.
+        if (!load_a ||
+            load_a->name != store->name ||
+            !is_one(load_a->predicate) ||
+            !is_one(store->predicate) ||
+            !store_var ||
+            !load_var ||
+            store_var->name != load_var->name ||
+            !scope.contains(store_var->name) ||
+            reduce_op == VectorReduce::And ||
+            reduce_op == VectorReduce::Or) {
+            return Stmt();
+        }
+
+        // Likewise the value must be a constant or a lifted expression.
+        if (!is_const(b) && !(var_b && scope.contains(var_b->name))) {
+            return Stmt();
+        }
+
+        // If the index turns out to be a ramp, it's a regular
+        // vectorizable reduction.
+        InterleavedRamp ir;
+        if (is_interleaved_ramp(scope.get(store_var->name), vector_scope, &ir)) {
+            return Stmt();
+        }
+
+        Expr index = mutate(store->index);
+        const int lanes = index.type().lanes();
+        Expr value = widen(mutate(b), lanes);
+        Type t = value.type();
+
+        auto combine = [=](const Expr &x, const Expr &y) {
+            switch (reduce_op) {
+            case VectorReduce::Add:
+                return x + y;
+            case VectorReduce::Mul:
+                return x * y;
+            case VectorReduce::Min:
+                return min(x, y);
+            case VectorReduce::Max:
+                return max(x, y);
+            default:
+                internal_error << "Unhandled VectorReduce operator\n";
+                return Expr();
+            }
+        };
+
+        // Combine the values of all lanes that share an index. Bind
+        // each step to a let, because each step uses the previous
+        // one twice.
+        vector<pair<string, Expr>> lets;
+        string combined_name = unique_name('t');
+        string overwritten_name = unique_name('t');
+        lets.emplace_back(combined_name, value);
+        lets.emplace_back(overwritten_name, const_false(lanes));
+        for (int k = 1; k < lanes; k++) {
+            vector<int> rotation(lanes);
+            for (int i = 0; i < lanes; i++) {
+                rotation[i] = (i + k) % lanes;
+            }
+            Expr combined = Variable::make(t, combined_name);
+            Expr overwritten = Variable::make(Bool(lanes), overwritten_name);
+            Expr conflict = (Shuffle::make({index}, rotation) == index);
+            // The lanes for which the rotated lane comes later in the vector.
+            Expr later = Ramp::make(0, 1, lanes) < Broadcast::make(lanes - k, lanes);
+
+            combined_name = unique_name('t');
+            overwritten_name = unique_name('t');
+            lets.emplace_back(combined_name,
+                              select(conflict, combine(combined, Shuffle::make({value}, rotation)), combined));
+            lets.emplace_back(overwritten_name, overwritten || (conflict && later));
+        }
+
+        Expr combined = Variable::make(t, combined_name);
+        Expr overwritten = Variable::make(Bool(lanes), overwritten_name);
+        Expr old = Load::make(t, load_a->name, index, load_a->image,
+                              load_a->param, const_true(lanes), ModulusRemainder{});
+        Expr new_value;
+        if (reduce_op == VectorReduce::Add) {
+            // Keep this in a form that can become an atomic add.
+            new_value = old + select(overwritten, make_zero(t), combined);
+        } else {
+            new_value = select(overwritten, old, combine(old, combined));
+        }
+
+        Stmt s = Store::make(store->name, new_value, index, store->param,
+                             const_true(lanes), ModulusRemainder{});
+        s = Atomic::make(op->producer_name, op->mutex_name, s);
+        while (!lets.empty()) {
+            s = LetStmt::make(lets.back().first, lets.back().second, s);
+            lets.pop_back();
+        }
+        return s;
+    }
+
     Stmt visit(const Atomic *op) override {
         // Recognize a few special cases that we can handle as within-vector reduction trees.
         do {
@@ -1100,6 +1220,12 @@ class VectorSubs : public IRMutator {
                 std::swap(a, b);
             }
 
+            // f[g[x]] = f[g[x]] <op> y, e.g. a histogram.
+            Stmt scattered = vectorize_scattered_update(op, store, a, b, reduce_op);
+            if (scattered.defined()) {
+                return scattered;
+            }
+
             // We require b to be a var, because it should have been lifted.
             const Variable *var_b = b.as<Variable>();
             const Load *load_a = a.as<Load>();
@@ -1416,6 +1542,324 @@ public:
     }
 };
 
+/** Find the names of all the buffers loaded from in an Expr. */
+class FindLoads : public IRVisitor {
+    using IRVisitor::visit;
+
+    void visit(const Load *op) override {
+        names.insert(op->name);
+        IRVisitor::visit(op);
+    }
+
+public:
+    std::set<string> names;
+};
+
+std::set<string> loads_in(const Expr &e) {
+    FindLoads finder;
+    e.accept(&finder);
+    return finder.names;
+}
+
+/** Replace the loads in an Expr with variables bounded by the range
+ * of their type, so that bounds inference gives the range of values
+ * the Expr could take for any contents of the buffers. */
+class ReplaceLoadsWithBoundedVars : public IRMutator {
+    using IRMutator::visit;
+
+    Expr visit(const Load *op) override {
+        string name = unique_name('t');
+        scope.push(name, Interval(op->type.min(), op->type.max()));
+        return Variable::make(op->type, name);
+    }
+
+public:
+    Scope<Interval> scope;
+};
+
+/** Privatize vectorized scattered updates, such as histograms, whose
+ * index is known to lie in a small range. Each lane gets its own copy
+ * of that range of the buffer, so the lanes never conflict and never
+ * need atomics. The copies are interleaved, so that all the lanes'
+ * values for one index are contiguous, and they are reduced back
+ * into the buffer after the enclosing serial loops, one vector
+ * reduction per index. Updates this doesn't handle fall through to
+ * VectorSubs, which combines conflicting lanes within each vector
+ * instead. */
+class PrivatizeScatteredUpdates : public IRMutator {
+    using IRMutator::visit;
+
+    // The largest set of private copies we'll make, in bytes.
+    static const int max_privatized_bytes = 64 * 1024;
+
+    struct Privatization {
+        string name;
+        Stmt update;  // Owns the store and load below.
+        const Store *store;
+        const Load *load;
+        string producer_name;
+        VectorReduce::Operator reduce_op;
+        Expr identity, min_index;
+        int extent, lanes;
+    };
+
+    // Privatizations that may still be hoisted out of the enclosing loop.
+    vector<Privatization> pending;
+
+    // Whether the loop being visited is directly inside a serial loop,
+    // separated from it by at most some lets. If so, these are the
+    // names that loop and the lets define, and the values they use.
+    bool in_serial_loop = false;
+    vector<string> enclosing_names;
+    vector<Expr> enclosing_values;
+
+    static Expr combine(VectorReduce::Operator op, const Expr &a, const Expr &b) {
+        switch (op) {
+        case VectorReduce::Add:
+            return a + b;
+        case VectorReduce::Mul:
+            return a * b;
+        case VectorReduce::Min:
+            return min(a, b);
+        case VectorReduce::Max:
+            return max(a, b);
+        default:
+            internal_error << "Unhandled VectorReduce operator\n";
+            return Expr();
+        }
+    }
+
+    // Whether a privatization can't be hoisted out of the loop
+    // enclosing the one being visited.
+    bool must_wrap_here(const Privatization &p) const {
+        if (!in_serial_loop) {
+            return true;
+        }
+        for (const string &n : enclosing_names) {
+            if (expr_uses_var(p.min_index, n)) {
+                return true;
+            }
+        }
+        for (const Expr &e : enclosing_values) {
+            if (loads_in(e).count(p.store->name)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Rewrite a vectorized loop whose body is a scattered atomic
+    // update to update private copies instead. Returns an undefined
+    // Stmt if it doesn't have that form.
+    Stmt privatize(const For *op) {
+        const IntImm *lanes = op->extent.as<IntImm>();
+        if (!lanes) {
+            return Stmt();
+        }
+
+        // The update, after the exprs lifted out of it.
+        vector<pair<string, Expr>> lets;
+        Stmt body = op->body;
+        while (const LetStmt *let = body.as<LetStmt>()) {
+            lets.emplace_back(let->name, let->value);
+            body = let->body;
+        }
+        const Atomic *atomic = body.as<Atomic>();
+        if (!atomic || !atomic->mutex_name.empty()) {
+            return Stmt();
+        }
+        const Store *store = atomic->body.as<Store>();
+        if (!store || !is_one(store->predicate) ||
+            !store->value.type().is_scalar() ||
+            store->value.type().is_bool()) {
+            return Stmt();
+        }
+
+        // f[g[x]] = f[g[x]] <op> y
+        Type t = store->value.type();
+        VectorReduce::Operator reduce_op;
+        Expr a, b;
+        if (const Add *add = store->value.as<Add>()) {
+            a = add->a;
+            b = add->b;
+            reduce_op = VectorReduce::Add;
+        } else if (const Mul *mul = store->value.as<Mul>()) {
+            a = mul->a;
+            b = mul->b;
+            reduce_op = VectorReduce::Mul;
+        } else if (const Min *min = store->value.as<Min>()) {
+            a = min->a;
+            b = min->b;
+            reduce_op = VectorReduce::Min;
+        } else if (const Max *max = store->value.as<Max>()) {
+            a = max->a;
+            b = max->b;
+            reduce_op = VectorReduce::Max;
+        } else {
+            return Stmt();
+        }
+        if (!a.as<Load>()) {
+            std::swap(a, b);
+        }
+        const Load *load = a.as<Load>();
+        if (!load ||
+            load->name != store->name ||
+            !is_one(load->predicate) ||
+            !equal(load->index, store->index)) {
+            return Stmt();
+        }
+
+        Expr identity;
+        switch (reduce_op) {
+        case VectorReduce::Add:
+            identity = make_zero(t);
+            break;
+        case VectorReduce::Mul:
+            identity = make_one(t);
+            break;
+        case VectorReduce::Min:
+            identity = t.max();
+            break;
+        default:
+            identity = t.min();
+            break;
+        }
+        if (t.is_float() && t.bits() == 16 &&
+            (reduce_op == VectorReduce::Min || reduce_op == VectorReduce::Max)) {
+            // The float16 type bounds are finite, so aren't identities.
+            return Stmt();
+        }
+
+        Expr index = store->index, value = b;
+        for (auto it = lets.rbegin(); it != lets.rend(); it++) {
+            index = substitute(it->first, it->second, index);
+            value = substitute(it->first, it->second, value);
+        }
+
+        // The index must depend on some other buffer (otherwise it's
+        // an ordinary vectorizable reduction), and neither it nor the
+        // value may depend on the buffer being updated.
+        std::set<string> index_loads = loads_in(index);
+        if (index_loads.empty() ||
+            index_loads.count(store->name) ||
+            loads_in(value).count(store->name)) {
+            return Stmt();
+        }
+
+        // The range of the index must be small, and known outside
+        // this loop.
+        ReplaceLoadsWithBoundedVars replacer;
+        Interval bounds = bounds_of_expr_in_scope(replacer.mutate(index), replacer.scope);
+        if (!bounds.is_bounded()) {
+            return Stmt();
+        }
+        Expr min_index = simplify(bounds.min);
+        const IntImm *extent = simplify(bounds.max - bounds.min + 1).as<IntImm>();
+        if (!extent ||
+            extent->value <= 0 ||
+            extent->value * lanes->value * t.bytes() > max_privatized_bytes ||
+            expr_uses_var(min_index, op->name)) {
+            return Stmt();
+        }
+
+        Privatization p{unique_name(store->name + ".per_lane"), atomic->body, store, load,
+                        atomic->producer_name, reduce_op, identity, min_index,
+                        (int)extent->value, (int)lanes->value};
+        if (must_wrap_here(p)) {
+            // Making and reducing the copies for each vector would
+            // cost more than it saves.
+            return Stmt();
+        }
+
+        Expr lane = Variable::make(Int(32), op->name) - op->min;
+        Expr private_index = (store->index - min_index) * p.lanes + lane;
+        Expr old = Load::make(t, p.name, private_index, Buffer<>(), Parameter(),
+                              const_true(), ModulusRemainder());
+        Stmt s = Store::make(p.name, combine(reduce_op, old, b), private_index,
+                             Parameter(), const_true(), ModulusRemainder());
+        while (!lets.empty()) {
+            s = LetStmt::make(lets.back().first, lets.back().second, s);
+            lets.pop_back();
+        }
+        pending.push_back(p);
+        return For::make(op->name, op->min, op->extent, op->for_type, op->device_api, s);
+    }
+
+    // Allocate and initialize the private copies around a Stmt, and
+    // reduce them into the buffer after it.
+    Stmt wrap(const Privatization &p, const Stmt &s) {
+        Type t = p.store->value.type();
+        string i_name = p.name + ".i";
+        Expr i = Variable::make(Int(32), i_name);
+        Expr lanes = Ramp::make(i * p.lanes, 1, p.lanes);
+
+        Stmt init = Store::make(p.name, Broadcast::make(p.identity, p.lanes), lanes,
+                                Parameter(), const_true(p.lanes), ModulusRemainder());
+        init = For::make(i_name, 0, p.extent, ForType::Serial, DeviceAPI::None, init);
+
+        string v_name = unique_name('t');
+        Expr v = Variable::make(t, v_name);
+        Expr index = i + p.min_index;
+        Expr old = Load::make(t, p.load->name, index, p.load->image, p.load->param,
+                              const_true(), ModulusRemainder());
+        Stmt reduce = Store::make(p.store->name, combine(p.reduce_op, old, v), index,
+                                  p.store->param, const_true(), ModulusRemainder());
+        reduce = Atomic::make(p.producer_name, "", reduce);
+        // Skip the indices no lane updated, which needn't be in the
+        // buffer at all.
+        reduce = IfThenElse::make(v != p.identity, reduce);
+        Expr lane_values = Load::make(t.with_lanes(p.lanes), p.name, lanes, Buffer<>(),
+                                      Parameter(), const_true(p.lanes), ModulusRemainder());
+        reduce = LetStmt::make(v_name, VectorReduce::make(p.reduce_op, lane_values, 1), reduce);
+        reduce = For::make(i_name, 0, p.extent, ForType::Serial, DeviceAPI::None, reduce);
+
+        Stmt result = Block::make({init, s, reduce});
+        return Allocate::make(p.name, t, MemoryType::Auto, {p.extent * p.lanes},
+                              const_true(), result);
+    }
+
+    Stmt visit(const For *op) override {
+        if (op->device_api != DeviceAPI::None &&
+            op->device_api != DeviceAPI::Host) {
+            return op;
+        }
+
+        size_t first_pending = pending.size();
+        Stmt stmt;
+        if (op->for_type == ForType::Vectorized) {
+            stmt = privatize(op);
+        }
+        if (!stmt.defined()) {
+            vector<string> names = {op->name};
+            vector<Expr> values = {op->min, op->extent};
+            Stmt body = op->body;
+            while (const LetStmt *let = body.as<LetStmt>()) {
+                names.push_back(let->name);
+                values.push_back(let->value);
+                body = let->body;
+            }
+            bool serial = (op->for_type == ForType::Serial ||
+                           op->for_type == ForType::Unrolled);
+            ScopedValue<bool> old_in_serial_loop(in_serial_loop, serial && body.as<For>());
+            ScopedValue<vector<string>> old_names(enclosing_names, names);
+            ScopedValue<vector<Expr>> old_values(enclosing_values, values);
+            stmt = IRMutator::visit(op);
+        }
+
+        // Wrap this loop in any privatizations from inside it that
+        // can't be hoisted any further.
+        for (size_t i = first_pending; i < pending.size();) {
+            if (must_wrap_here(pending[i])) {
+                stmt = wrap(pending[i], stmt);
+                pending.erase(pending.begin() + i);
+            } else {
+                i++;
+            }
+        }
+        return stmt;
+    }
+};
+
 // Vectorize all loops marked as such in a Stmt
 class VectorizeLoops : public IRMutator {
     const Target &target;
@@ -1524,6 +1968,7 @@ Stmt vectorize_loops(const Stmt &stmt, const map<string, Function> &env, const T
     // TODO: Should this be an earlier pass? It's probably a good idea
     // for non-vectorizing stuff too.
     Stmt s = LiftVectorizableExprsOutOfAllAtomicNodes(env).mutate(stmt);
+    s = PrivatizeScatteredUpdates().mutate(s);
     s = VectorizeLoops(t).mutate(s);
     s = RemoveUnnecessaryAtomics().mutate(s);
     return s;
@@ -11,6 +11,7 @@
 #include <cassert>
 #include <limits>
 #include <memory>
+#include <mutex>
 #include <stdint.h>
 #include <string.h>
 #include <vector>
@@ -104,6 +105,187 @@ struct DeviceRefCount {
     BufferDeviceOwnership ownership{BufferDeviceOwnership::Allocated};
 };
 
+/** A pool of host allocations for Buffers, for code that repeatedly
+ * allocates buffers of the same size (e.g. the outputs of a pipeline
+ * run once per frame of a video). A Buffer allocated with
+ * Buffer::allocate(BufferPool &) returns its memory to the pool when
+ * the last Buffer sharing it is destroyed, and the next allocation of
+ * the same size reuses it instead of calling malloc. At most
+ * max_idle_bytes of released memory are kept; beyond that memory is
+ * freed as usual. Allocation and release are thread-safe, and Buffers
+ * may outlive the pool that allocated them. */
+class BufferPool {
+    struct State;
+
+    struct Block : AllocationHeader {
+        std::shared_ptr<State> state;
+        size_t size;
+        void *host;
+
+        Block(const std::shared_ptr<State> &state, size_t size, void *host)
+            : AllocationHeader(release), state(state), size(size), host(host) {
+        }
+    };
+
+    struct State {
+        std::mutex mutex;
+        std::vector<Block *> idle;
+        size_t idle_bytes = 0;
+        size_t max_idle_bytes;
+        bool open = true;
+
+        explicit State(size_t max_idle_bytes)
+            : max_idle_bytes(max_idle_bytes) {
+        }
+
+        // Free idle blocks, oldest first, until at most max_bytes remain.
+        // Must be called with the mutex held. The blocks are returned so
+        // they can be destroyed after the mutex is released; each one
+        // holds a reference to this State.
+        std::vector<Block *> trim(size_t max_bytes) {
+            std::vector<Block *> dead;
+            size_t i = 0;
+            while (i < idle.size() && idle_bytes > max_bytes) {
+                idle_bytes -= idle[i]->size;
+                dead.push_back(idle[i++]);
+            }
+            idle.erase(idle.begin(), idle.begin() + i);
+            return dead;
+        }
+    };
+
+    std::shared_ptr<State> state;
+
+    // The header of a block has already been destroyed by the time it
+    // gets here, so only drop the reference to the State.
+    static void destroy(Block *b) {
+        b->state.reset();
+        free(b);
+    }
+
+    // The deallocate_fn of every pooled allocation. Buffer::decref has
+    // already run ~AllocationHeader, so the header is rebuilt when the
+    // block is handed out again.
+    static void release(void *p) {
+        Block *b = (Block *)p;
+        std::vector<Block *> dead;
+        {
+            std::lock_guard<std::mutex> lock(b->state->mutex);
+            State &s = *b->state;
+            if (s.open && b->size <= s.max_idle_bytes) {
+                s.idle.push_back(b);
+                s.idle_bytes += b->size;
+                dead = s.trim(s.max_idle_bytes);
+                b = nullptr;
+            }
+        }
+        for (Block *d : dead) {
+            destroy(d);
+        }
+        if (b) {
+            destroy(b);
+        }
+    }
+
+public:
+    /** Construct a pool that keeps up to max_idle_bytes of released
+     * memory for reuse. */
+    explicit BufferPool(size_t max_idle_bytes = std::numeric_limits<size_t>::max())
+        : state(std::make_shared<State>(max_idle_bytes)) {
+    }
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    /** Free all idle memory. Buffers still using memory from the pool
+     * free it when they are destroyed. */
+    ~BufferPool() {
+        std::vector<Block *> dead;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->open = false;
+            dead = state->trim(0);
+        }
+        for (Block *d : dead) {
+            destroy(d);
+        }
+    }
+
+    /** Get an allocation of size bytes, aligned to 128 bytes, reusing
+     * an idle one of exactly that size if there is one. Sets *host to
+     * the start of the usable memory, and returns a header with a
+     * reference count of one, which returns the memory to the pool
+     * when it is released. Buffer::allocate(BufferPool &) is the
+     * usual way to call this. Returns nullptr if malloc fails. */
+    AllocationHeader *allocate(size_t size, void **host) {
+        Block *b = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            // Most recently released first; it's the most likely to still be in cache.
+            for (size_t i = state->idle.size(); i > 0; i--) {
+                if (state->idle[i - 1]->size == size) {
+                    b = state->idle[i - 1];
+                    state->idle.erase(state->idle.begin() + (i - 1));
+                    state->idle_bytes -= size;
+                    break;
+                }
+            }
+        }
+        if (b) {
+            new (b) AllocationHeader(release);
+        } else {
+            const size_t alignment = 128;
+            void *storage = malloc(sizeof(Block) + size + alignment - 1);
+            if (!storage) {
+                return nullptr;
+            }
+            uint8_t *unaligned_ptr = (uint8_t *)storage + sizeof(Block);
+            void *aligned_ptr = (void *)((uintptr_t)(unaligned_ptr + alignment - 1) & ~(alignment - 1));
+            b = new (storage) Block(state, size, aligned_ptr);
+        }
+        *host = b->host;
+        return b;
+    }
+
+    /** The number of bytes of released memory currently kept for
+     * reuse. */
+    size_t idle_bytes() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->idle_bytes;
+    }
+
+    /** Change the amount of released memory kept for reuse, freeing
+     * idle memory if there is now too much. */
+    void set_max_idle_bytes(size_t max_idle_bytes) {
+        std::vector<Block *> dead;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            state->max_idle_bytes = max_idle_bytes;
+            dead = state->trim(max_idle_bytes);
+        }
+        for (Block *d : dead) {
+            destroy(d);
+        }
+    }
+
+    /** Free all idle memory. */
+    void clear() {
+        std::vector<Block *> dead;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex);
+            dead = state->trim(0);
+        }
+        for (Block *d : dead) {
+            destroy(d);
+        }
+    }
+
+    size_t max_idle_bytes() const {
+        std::lock_guard<std::mutex> lock(state->mutex);
+        return state->max_idle_bytes;
+    }
+};
+
 /** A templated Buffer class that wraps halide_buffer_t and adds
  * functionality. When using Halide from C++, this is the preferred
  * way to create input and output buffers. The overhead of using this
@@ -786,11 +968,27 @@ public:
         const size_t alignment = 128;
         size = (size + alignment - 1) & ~(alignment - 1);
         void *alloc_storage = allocate_fn(size + sizeof(AllocationHeader) + alignment - 1);
+        assert(alloc_storage && "Buffer allocation failed");
         alloc = new (alloc_storage) AllocationHeader(deallocate_fn);
         uint8_t *unaligned_ptr = ((uint8_t *)alloc) + sizeof(AllocationHeader);
         buf.host = (uint8_t *)((uintptr_t)(unaligned_ptr + alignment - 1) & ~(alignment - 1));
     }
 
+    /** Allocate memory for this Buffer from a BufferPool, reusing
+     * memory released by an earlier Buffer of the same size if
+     * possible. Drops the reference to any owned memory. */
+    void allocate(BufferPool &pool) {
+        // Drop any existing allocation
+        deallocate();
+
+        const size_t alignment = 128;
+        size_t size = (size_in_bytes() + alignment - 1) & ~(alignment - 1);
+        void *host = nullptr;
+        alloc = pool.allocate(size, &host);
+        assert(alloc && "BufferPool allocation failed");
+        buf.host = (uint8_t *)host;
+    }
+
     /** Drop reference to any owned host or device memory, possibly
      * freeing it, if this buffer held the last reference to
      * it. Retains the shape of the buffer. Does nothing if this
@@ -991,6 +1189,20 @@ public:
         }
     }
 
+    /** Initialize a Buffer from a pointer to the min coordinate and
+     * an array describing the shape, sharing ownership of the data
+     * through the given allocation header. The header must have a
+     * reference count of one, which passes to this Buffer. When the
+     * last Buffer sharing it is destroyed, the header's deallocate_fn
+     * is called on the header, so it can be the start of a larger
+     * struct describing how to release memory the Buffer didn't
+     * allocate (e.g. a mapped file). Does not set the host_dirty flag. */
+    explicit Buffer(halide_type_t t, add_const_if_T_is_const<void> *data, int d, const halide_dimension_t *shape,
+                    AllocationHeader *owner)
+        : Buffer(t, data, d, shape) {
+        alloc = owner;
+    }
+
     /** Initialize a Buffer from a pointer to the min coordinate and
      * a vector describing the shape.  Does not take ownership of the
      * data, and does not set the host_dirty flag. */
@@ -1207,55 +1419,16 @@ public:
     */
     template<typename T2, int D2>
     void copy_from(const Buffer<T2, D2> &other) {
-        static_assert(!std::is_const<T>::value, "Cannot call copy_from() on a Buffer<const T>");
-        assert(!device_dirty() && "Cannot call Halide::Runtime::Buffer::copy_from on a device dirty destination.");
-        assert(!other.device_dirty() && "Cannot call Halide::Runtime::Buffer::copy_from on a device dirty source.");
-
-        Buffer<const T, D> src(other);
-        Buffer<T, D> dst(*this);
-
-        assert(src.dimensions() == dst.dimensions());
-
-        // Trim the copy to the region in common
-        for (int i = 0; i < dimensions(); i++) {
-            int min_coord = std::max(dst.dim(i).min(), src.dim(i).min());
-            int max_coord = std::min(dst.dim(i).max(), src.dim(i).max());
-            if (max_coord < min_coord) {
-                // The buffers do not overlap.
-                return;
-            }
-            dst.crop(i, min_coord, max_coord - min_coord + 1);
-            src.crop(i, min_coord, max_coord - min_coord + 1);
-        }
+        copy_from_impl(other, std::false_type());
+    }
 
-        // If T is void, we need to do runtime dispatch to an
-        // appropriately-typed lambda. We're copying, so we only care
-        // about the element size. (If not, this should optimize away
-        // into a static dispatch to the right-sized copy.)
-        if (T_is_void ? (type().bytes() == 1) : (sizeof(not_void_T) == 1)) {
-            using MemType = uint8_t;
-            auto &typed_dst = (Buffer<MemType, D> &)dst;
-            auto &typed_src = (Buffer<const MemType, D> &)src;
-            typed_dst.for_each_value([&](MemType &dst, MemType src) { dst = src; }, typed_src);
-        } else if (T_is_void ? (type().bytes() == 2) : (sizeof(not_void_T) == 2)) {
-            using MemType = uint16_t;
-            auto &typed_dst = (Buffer<MemType, D> &)dst;
-            auto &typed_src = (Buffer<const MemType, D> &)src;
-            typed_dst.for_each_value([&](MemType &dst, MemType src) { dst = src; }, typed_src);
-        } else if (T_is_void ? (type().bytes() == 4) : (sizeof(not_void_T) == 4)) {
-            using MemType = uint32_t;
-            auto &typed_dst = (Buffer<MemType, D> &)dst;
-            auto &typed_src = (Buffer<const MemType, D> &)src;
-            typed_dst.for_each_value([&](MemType &dst, MemType src) { dst = src; }, typed_src);
-        } else if (T_is_void ? (type().bytes() == 8) : (sizeof(not_void_T) == 8)) {
-            using MemType = uint64_t;
-            auto &typed_dst = (Buffer<MemType, D> &)dst;
-            auto &typed_src = (Buffer<const MemType, D> &)src;
-            typed_dst.for_each_value([&](MemType &dst, MemType src) { dst = src; }, typed_src);
-        } else {
-            assert(false && "type().bytes() must be 1, 2, 4, or 8");
-        }
-        set_host_dirty();
+    /** Like copy_from, but splits the copy into tasks run with
+     * halide_do_par_for, so that it uses the Halide thread pool. Small
+     * copies are done on the calling thread. Requires linking a Halide
+     * runtime. */
+    template<typename T2, int D2>
+    void copy_from_parallel(const Buffer<T2, D2> &other) {
+        copy_from_impl(other, std::true_type());
     }
 
     /** Make an image that refers to a sub-range of this image along
@@ -1949,7 +2122,89 @@ public:
         return *this;
     }
 
+    /** Like fill, but runs in parallel with halide_do_par_for. See
+     * for_each_value_parallel. */
+    Buffer<T, D> &fill_parallel(not_void_T val) {
+        set_host_dirty();
+        for_each_value_parallel([=](T &v) { v = val; });
+        return *this;
+    }
+
 private:
+    /** Helpers for copy_from. Whether the copy is parallel is a
+     * type (std::true_type or std::false_type) rather than a bool, so
+     * that a serial copy_from never instantiates anything that calls
+     * halide_do_par_for, and works without a Halide runtime. */
+    // @{
+    template<typename MemType>
+    static void copy_values(Buffer<MemType, D> &dst, const Buffer<const MemType, D> &src, std::false_type) {
+        dst.for_each_value([](MemType &dst, MemType src) { dst = src; }, src);
+    }
+
+    template<typename MemType>
+    static void copy_values(Buffer<MemType, D> &dst, const Buffer<const MemType, D> &src, std::true_type) {
+        dst.for_each_value_parallel([](MemType &dst, MemType src) { dst = src; }, src);
+    }
+
+    template<typename T2, int D2, typename Parallel>
+    void copy_from_impl(const Buffer<T2, D2> &other, Parallel parallel) {
+        static_assert(!std::is_const<T>::value, "Cannot call copy_from() on a Buffer<const T>");
+        assert(!device_dirty() && "Cannot call Halide::Runtime::Buffer::copy_from on a device dirty destination.");
+        assert(!other.device_dirty() && "Cannot call Halide::Runtime::Buffer::copy_from on a device dirty source.");
+
+        Buffer<const T, D> src(other);
+        Buffer<T, D> dst(*this);
+
+        assert(src.dimensions() == dst.dimensions());
+
+        // Trim the copy to the region in common
+        for (int i = 0; i < dimensions(); i++) {
+            int min_coord = std::max(dst.dim(i).min(), src.dim(i).min());
+            int max_coord = std::min(dst.dim(i).max(), src.dim(i).max());
+            if (max_coord < min_coord) {
+                // The buffers do not overlap.
+                return;
+            }
+            dst.crop(i, min_coord, max_coord - min_coord + 1);
+            src.crop(i, min_coord, max_coord - min_coord + 1);
+        }
+
+        // If the innermost dimension is dense in both buffers, once
+        // dense dimensions have been collapsed together, copy whole
+        // rows with memcpy.
+        Buffer<>::for_each_value_task_dim<2> *t =
+            (Buffer<>::for_each_value_task_dim<2> *)HALIDE_ALLOCA((dimensions() + 1) * sizeof(Buffer<>::for_each_value_task_dim<2>));
+        const halide_buffer_t *buffers[] = {&dst.buf, &src.buf};
+        if (Buffer<>::for_each_value_prep(t, buffers)) {
+            Buffer<>::copy_rows(t, dimensions(), type().bytes(),
+                                (uint8_t *)dst.data(), (const uint8_t *)src.data(), parallel);
+            set_host_dirty();
+            return;
+        }
+
+        // If T is void, we need to do runtime dispatch to an
+        // appropriately-typed lambda. We're copying, so we only care
+        // about the element size. (If not, this should optimize away
+        // into a static dispatch to the right-sized copy.)
+        if (T_is_void ? (type().bytes() == 1) : (sizeof(not_void_T) == 1)) {
+            using MemType = uint8_t;
+            copy_values((Buffer<MemType, D> &)dst, (Buffer<const MemType, D> &)src, parallel);
+        } else if (T_is_void ? (type().bytes() == 2) : (sizeof(not_void_T) == 2)) {
+            using MemType = uint16_t;
+            copy_values((Buffer<MemType, D> &)dst, (Buffer<const MemType, D> &)src, parallel);
+        } else if (T_is_void ? (type().bytes() == 4) : (sizeof(not_void_T) == 4)) {
+            using MemType = uint32_t;
+            copy_values((Buffer<MemType, D> &)dst, (Buffer<const MemType, D> &)src, parallel);
+        } else if (T_is_void ? (type().bytes() == 8) : (sizeof(not_void_T) == 8)) {
+            using MemType = uint64_t;
+            copy_values((Buffer<MemType, D> &)dst, (Buffer<const MemType, D> &)src, parallel);
+        } else {
+            assert(false && "type().bytes() must be 1, 2, 4, or 8");
+        }
+        set_host_dirty();
+    }
+    // @}
+
     /** Helper functions for for_each_value. */
     // @{
     template<int N>
@@ -1971,6 +2226,17 @@ private:
     static void advance_ptrs(const int *) {
     }
 
+    // Advance the pointers by some multiple of the strides.
+    template<typename Ptr, typename... Ptrs>
+    HALIDE_ALWAYS_INLINE static void advance_ptrs_by(const int *stride, int64_t n, Ptr *ptr, Ptrs... ptrs) {
+        (*ptr) += *stride * n;
+        advance_ptrs_by(stride + 1, n, ptrs...);
+    }
+
+    HALIDE_ALWAYS_INLINE
+    static void advance_ptrs_by(const int *, int64_t) {
+    }
+
     // Same as the above, but just increments the pointers.
     template<typename Ptr, typename... Ptrs>
     HALIDE_ALWAYS_INLINE static void increment_ptrs(Ptr *ptr, Ptrs... ptrs) {
@@ -2071,6 +2337,126 @@ private:
         return innermost_strides_are_one;
     }
 
+    // Run body(begin, end) over slices of [0, extent) using
+    // halide_do_par_for. Each task gets enough slices to do at least
+    // 128KB of work, so small loops stay on the calling thread.
+    template<typename Body>
+    static void parallel_slices(int extent, int64_t bytes_per_slice, const Body &body) {
+        const int64_t min_bytes_per_task = 128 * 1024;
+        const int64_t slices_per_task =
+            std::max((int64_t)1, (min_bytes_per_task + bytes_per_slice - 1) / bytes_per_slice);
+        const int tasks = (int)((extent + slices_per_task - 1) / slices_per_task);
+        if (tasks <= 1) {
+            body(0, extent);
+            return;
+        }
+        struct Closure {
+            const Body *body;
+            int extent;
+            int64_t slices_per_task;
+
+            static int run(void *, int task, uint8_t *closure) {
+                const Closure *c = (const Closure *)closure;
+                int begin = (int)(task * c->slices_per_task);
+                int end = (int)std::min((int64_t)c->extent, begin + c->slices_per_task);
+                (*c->body)(begin, end);
+                return 0;
+            }
+        } closure = {&body, extent, slices_per_task};
+        halide_do_par_for(nullptr, Closure::run, 0, tasks, (uint8_t *)&closure);
+    }
+
+    // The outermost dimension with more than one element, which is
+    // the one to split across tasks, or -1 if there isn't one.
+    template<int N>
+    static int outermost_nontrivial_dim(const for_each_value_task_dim<N> *t, int dimensions) {
+        for (int d = dimensions - 1; d >= 0; d--) {
+            if (t[d].extent > 1) {
+                return d;
+            }
+        }
+        return -1;
+    }
+
+    // Copy between two buffers prepared by for_each_value_prep, whose
+    // innermost dimension is dense in both, with one memcpy per row.
+    static void copy_rows_helper(int d, const for_each_value_task_dim<2> *t, int elem_size,
+                                 uint8_t *dst, const uint8_t *src) {
+        if (d <= 0) {
+            memcpy(dst, src, (size_t)(d < 0 ? 1 : t[0].extent) * elem_size);
+        } else {
+            for (int i = t[d].extent; i != 0; i--) {
+                copy_rows_helper(d - 1, t, elem_size, dst, src);
+                dst += (int64_t)t[d].stride[0] * elem_size;
+                src += (int64_t)t[d].stride[1] * elem_size;
+            }
+        }
+    }
+
+    static void copy_rows(const for_each_value_task_dim<2> *t, int dimensions, int elem_size,
+                          uint8_t *dst, const uint8_t *src, std::false_type) {
+        copy_rows_helper(dimensions - 1, t, elem_size, dst, src);
+    }
+
+    static void copy_rows(const for_each_value_task_dim<2> *t, int dimensions, int elem_size,
+                          uint8_t *dst, const uint8_t *src, std::true_type) {
+        const int d = outermost_nontrivial_dim(t, dimensions);
+        if (d < 0) {
+            copy_rows_helper(dimensions - 1, t, elem_size, dst, src);
+            return;
+        }
+        int64_t bytes_per_slice = elem_size;
+        for (int i = 0; i < d; i++) {
+            bytes_per_slice *= t[i].extent;
+        }
+        parallel_slices(t[d].extent, bytes_per_slice, [&](int begin, int end) {
+            for_each_value_task_dim<2> *slice =
+                (for_each_value_task_dim<2> *)HALIDE_ALLOCA((d + 1) * sizeof(for_each_value_task_dim<2>));
+            memcpy(slice, t, (d + 1) * sizeof(for_each_value_task_dim<2>));
+            slice[d].extent = end - begin;
+            copy_rows_helper(d, slice, elem_size,
+                             dst + (int64_t)begin * t[d].stride[0] * elem_size,
+                             src + (int64_t)begin * t[d].stride[1] * elem_size);
+        });
+    }
+
+    template<typename Fn, typename... Ptrs>
+    static void for_each_value_slice(Fn &&f, int d, bool innermost_strides_are_one,
+                                     const for_each_value_task_dim<sizeof...(Ptrs)> *t,
+                                     int64_t begin, Ptrs... ptrs) {
+        advance_ptrs_by(t[d].stride, begin, (&ptrs)...);
+        for_each_value_helper(f, d, innermost_strides_are_one, t, ptrs...);
+    }
+
+    template<typename Fn, typename... Args, int N = sizeof...(Args) + 1>
+    void for_each_value_parallel_impl(Fn &&f, Args &&... other_buffers) const {
+        Buffer<>::for_each_value_task_dim<N> *t =
+            (Buffer<>::for_each_value_task_dim<N> *)HALIDE_ALLOCA((dimensions() + 1) * sizeof(for_each_value_task_dim<N>));
+        const halide_buffer_t *buffers[] = {&buf, (&other_buffers.buf)...};
+        bool innermost_strides_are_one = Buffer<>::for_each_value_prep(t, buffers);
+
+        const int d = Buffer<>::outermost_nontrivial_dim(t, dimensions());
+        if (d < 0) {
+            Buffer<>::for_each_value_helper(f, dimensions() - 1,
+                                            innermost_strides_are_one,
+                                            t,
+                                            data(), (other_buffers.data())...);
+            return;
+        }
+        int64_t bytes_per_slice = sizeof(not_void_T);
+        for (int i = 0; i < d; i++) {
+            bytes_per_slice *= t[i].extent;
+        }
+        Buffer<>::parallel_slices(t[d].extent, bytes_per_slice, [&](int begin, int end) {
+            Buffer<>::for_each_value_task_dim<N> *slice =
+                (Buffer<>::for_each_value_task_dim<N> *)HALIDE_ALLOCA((d + 1) * sizeof(for_each_value_task_dim<N>));
+            memcpy(slice, t, (d + 1) * sizeof(for_each_value_task_dim<N>));
+            slice[d].extent = end - begin;
+            Buffer<>::for_each_value_slice(f, d, innermost_strides_are_one, slice, begin,
+                                           data(), (other_buffers.data())...);
+        });
+    }
+
     template<typename Fn, typename... Args, int N = sizeof...(Args) + 1>
     void for_each_value_impl(Fn &&f, Args &&... other_buffers) const {
         Buffer<>::for_each_value_task_dim<N> *t =
@@ -2118,6 +2504,28 @@ public:
     }
     // @}
 
+    /** Like for_each_value, but splits the buffers along their
+     * outermost dimension (after collapsing dense dimensions together)
+     * into tasks run with halide_do_par_for, so that the work shares
+     * the Halide thread pool. The function may be called concurrently
+     * from several threads. Small buffers are done on the calling
+     * thread. Requires linking a Halide runtime. */
+    // @{
+    template<typename Fn, typename... Args, int N = sizeof...(Args) + 1>
+    HALIDE_ALWAYS_INLINE const Buffer<T, D> &for_each_value_parallel(Fn &&f, Args &&... other_buffers) const {
+        for_each_value_parallel_impl(f, std::forward<Args>(other_buffers)...);
+        return *this;
+    }
+
+    template<typename Fn, typename... Args, int N = sizeof...(Args) + 1>
+    HALIDE_ALWAYS_INLINE
+        Buffer<T, D> &
+        for_each_value_parallel(Fn &&f, Args &&... other_buffers) {
+        for_each_value_parallel_impl(f, std::forward<Args>(other_buffers)...);
+        return *this;
+    }
+    // @}
+
 private:
     // Helper functions for for_each_element
     struct for_each_element_task_dim {
@@ -357,6 +357,24 @@ extern halide_malloc_t halide_set_custom_malloc(halide_malloc_t user_malloc);
 extern halide_free_t halide_set_custom_free(halide_free_t user_free);
 //@}
 
+/** Set whether halide_default_free keeps freed memory for reuse by
+ * later calls to halide_default_malloc, within and across pipeline
+ * invocations, instead of returning it to the system allocator. This
+ * helps pipelines with allocations inside loops, which otherwise call
+ * malloc and free on every iteration. Allocations are rounded up to
+ * one of four size classes per power of two, and kept in free lists
+ * mostly private to each thread. The default value is false.
+ *
+ * If set to false, all cached memory is freed. Has no effect on
+ * Hexagon, or if halide_malloc has been replaced. */
+extern int halide_reuse_host_allocations(void *user_context, bool);
+
+/** Set the maximum number of bytes that halide_reuse_host_allocations
+ * keeps cached across all threads, freeing cached memory if there is
+ * now more than that. Memory freed while the cache is full is returned
+ * to the system allocator. The default is 256MB. */
+extern void halide_host_allocation_cache_set_size(int64_t size);
+
 /** Halide calls these functions to interact with the underlying
  * system runtime functions. To replace in AOT code on platforms that
  * support weak linking, define these functions yourself, or use
@@ -1319,8 +1337,10 @@ typedef enum halide_target_feature_t {
     halide_target_feature_sve2,                   ///< Enable ARM Scalable Vector Extensions v2
     halide_target_feature_egl,                    ///< Force use of EGL support.
 
-    halide_target_feature_arm_dot_prod,  ///< Enable ARMv8.2-a dotprod extension (i.e. udot and sdot instructions)
-    halide_target_feature_end            ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
+    halide_target_feature_arm_dot_prod,   ///< Enable ARMv8.2-a dotprod extension (i.e. udot and sdot instructions)
+    halide_target_feature_loop_carry,     ///< Carry loads (including sliding windows of vectors) across loop iterations in registers.
+    halide_target_feature_fuse_siblings,  ///< Automatically compute_with sibling Funcs that read a common compute_root producer.
+    halide_target_feature_end             ///< A sentinel. Every target is considered to have this feature, and setting this feature does nothing.
 } halide_target_feature_t;
 
 /** This function is called internally by Halide in some situations to determine
@@ -71,6 +71,79 @@ WEAK void copy_memory(const device_copy &copy, void *user_context) {
     }
 }
 
+// Host copies of fewer than this many bytes are done on the calling
+// thread. Larger ones are split into tasks of about
+// PARALLEL_COPY_TASK_BYTES each and run on the thread pool.
+#define MIN_PARALLEL_COPY_BYTES (1024 * 1024)
+#define PARALLEL_COPY_TASK_BYTES (256 * 1024)
+
+struct copy_memory_closure {
+    const device_copy *copy;
+    // The dimension split across tasks, or -1 if the copy is a single
+    // chunk, in which case the chunk itself is split.
+    int d;
+    // How many slices of that dimension (or bytes of the chunk) each
+    // task does.
+    uint64_t slices_per_task;
+};
+
+WEAK int copy_memory_task(void *user_context, int task, uint8_t *closure) {
+    const copy_memory_closure *c = (const copy_memory_closure *)closure;
+    const device_copy &copy = *(c->copy);
+    uint64_t begin = task * c->slices_per_task;
+    if (c->d == -1) {
+        uint64_t end = min(begin + c->slices_per_task, copy.chunk_size);
+        const void *from = (void *)(copy.src + copy.src_begin + begin);
+        void *to = (void *)(copy.dst + begin);
+        memcpy(to, from, end - begin);
+    } else {
+        uint64_t end = min(begin + c->slices_per_task, copy.extent[c->d]);
+        int64_t src_off = copy.src_begin + begin * copy.src_stride_bytes[c->d];
+        int64_t dst_off = begin * copy.dst_stride_bytes[c->d];
+        for (uint64_t i = begin; i < end; i++) {
+            copy_memory_helper(copy, c->d - 1, src_off, dst_off);
+            src_off += copy.src_stride_bytes[c->d];
+            dst_off += copy.dst_stride_bytes[c->d];
+        }
+    }
+    return 0;
+}
+
+// Like copy_memory, but large copies between host pointers are spread
+// across halide_do_par_for. This must not be called with
+// device_copy_mutex held: a thread waiting in halide_do_par_for can
+// pick up other tasks, which may try to take that lock themselves.
+WEAK void copy_memory_parallel(const device_copy &copy, void *user_context) {
+    if (copy.src == copy.dst) {
+        debug(user_context) << "copy_memory_parallel: no copy needed as pointers are the same.\n";
+        return;
+    }
+
+    // Split the outermost dimension that has more than one slice.
+    int d = MAX_COPY_DIMS - 1;
+    while (d >= 0 && copy.extent[d] == 1) {
+        d--;
+    }
+    uint64_t bytes_per_slice = (d == -1) ? 1 : copy.chunk_size;
+    for (int i = 0; i < d; i++) {
+        bytes_per_slice *= copy.extent[i];
+    }
+    uint64_t slices = (d == -1) ? copy.chunk_size : copy.extent[d];
+    if (slices * bytes_per_slice >= MIN_PARALLEL_COPY_BYTES) {
+        uint64_t slices_per_task = (PARALLEL_COPY_TASK_BYTES + bytes_per_slice - 1) / bytes_per_slice;
+        uint64_t tasks = (slices + slices_per_task - 1) / slices_per_task;
+        if (tasks > 1 && tasks < 0x7fffffff) {
+            copy_memory_closure closure = {&copy, d, slices_per_task};
+            if (halide_do_par_for(user_context, copy_memory_task, 0, (int)tasks, (uint8_t *)&closure) == 0) {
+                return;
+            }
+            // The tasks can't fail, but a custom do_par_for might. Copy
+            // everything again on this thread.
+        }
+    }
+    copy_memory_helper(copy, MAX_COPY_DIMS - 1, copy.src_begin, 0);
+}
+
 // Fills the entire dst buffer, which must be contained within src
 WEAK device_copy make_buffer_copy(const halide_buffer_t *src, bool src_host,
                                   const halide_buffer_t *dst, bool dst_host) {
@@ -135,6 +208,22 @@ WEAK device_copy make_buffer_copy(const halide_buffer_t *src, bool src_host,
         c.src_stride_bytes[insert] = src_stride_bytes;
     };
 
+    // Drop dimensions of extent one, which don't change what's copied,
+    // so that they don't get in the way of the folding below.
+    for (int i = 0, j = 0; i < MAX_COPY_DIMS; i++) {
+        if (c.extent[i] != 1) {
+            c.extent[j] = c.extent[i];
+            c.src_stride_bytes[j] = c.src_stride_bytes[i];
+            c.dst_stride_bytes[j] = c.dst_stride_bytes[i];
+            j++;
+        }
+        if (i >= j) {
+            c.extent[i] = 1;
+            c.src_stride_bytes[i] = 0;
+            c.dst_stride_bytes[i] = 0;
+        }
+    }
+
     // Attempt to fold contiguous dimensions into the chunk
     // size. Since the dimensions are sorted by stride, and the
     // strides must be greater than or equal to the chunk size, this
@@ -156,6 +245,26 @@ WEAK device_copy make_buffer_copy(const halide_buffer_t *src, bool src_host,
         c.src_stride_bytes[MAX_COPY_DIMS - 1] = 0;
         c.dst_stride_bytes[MAX_COPY_DIMS - 1] = 0;
     }
+
+    // Fuse the remaining dimensions where one steps over exactly the
+    // whole of the next-innermost one in both src and dst (e.g. the
+    // rows of a crop in x only), so that there are fewer, longer loops
+    // around the chunks.
+    for (int i = 1; i < MAX_COPY_DIMS && c.extent[i] != 1; i++) {
+        if (c.src_stride_bytes[i] == c.src_stride_bytes[i - 1] * c.extent[i - 1] &&
+            c.dst_stride_bytes[i] == c.dst_stride_bytes[i - 1] * c.extent[i - 1]) {
+            c.extent[i - 1] *= c.extent[i];
+            for (int j = i + 1; j < MAX_COPY_DIMS; j++) {
+                c.extent[j - 1] = c.extent[j];
+                c.src_stride_bytes[j - 1] = c.src_stride_bytes[j];
+                c.dst_stride_bytes[j - 1] = c.dst_stride_bytes[j];
+            }
+            c.extent[MAX_COPY_DIMS - 1] = 1;
+            c.src_stride_bytes[MAX_COPY_DIMS - 1] = 0;
+            c.dst_stride_bytes[MAX_COPY_DIMS - 1] = 0;
+            i--;
+        }
+    }
     return c;
 }
 
@@ -595,6 +595,21 @@ WEAK int halide_buffer_copy(void *user_context, struct halide_buffer_t *src,
                         << " interface " << dst_device_interface << "\n"
                         << " dst " << *dst << "\n";
 
+    // A copy between two buffers that only live on the host touches no
+    // device state, so it doesn't need device_copy_mutex. Doing it
+    // without the lock also lets large copies use the thread pool.
+    if (dst_device_interface == NULL &&
+        src->device == 0 && dst->device == 0 &&
+        src->host != NULL && dst->host != NULL) {
+        device_copy c = make_buffer_copy(src, true, dst, true);
+        copy_memory_parallel(c, user_context);
+        if (dst != src) {
+            dst->set_host_dirty(true);
+            dst->set_device_dirty(false);
+        }
+        return 0;
+    }
+
     ScopedMutexLock lock(&device_copy_mutex);
 
     if (dst_device_interface) {
@@ -2,13 +2,130 @@
 #include "runtime_internal.h"
 
 #include "printer.h"
+#include "scoped_mutex_lock.h"
 
 extern "C" {
 
 extern void *malloc(size_t);
 extern void free(void *);
+}
+
+namespace Halide {
+namespace Runtime {
+namespace Internal {
+
+// While halide_reuse_host_allocations is on, halide_default_malloc
+// rounds allocations up to a size class, and halide_default_free keeps
+// them in a free list for that class for the next allocation of the
+// same class. There are four classes per power of two from 64 bytes to
+// 1GB, so at most a fifth of a block is wasted. Larger allocations
+// aren't cached.
+const int host_size_class_min_log2 = 6;
+const int host_size_class_max_log2 = 30;
+const int num_host_size_classes = 1 + (host_size_class_max_log2 - host_size_class_min_log2) * 4;
+
+// The free lists are split into shards, chosen by the address of the
+// caller's stack. Threads run on separate stacks, so this gives each
+// thread a shard that's almost always its own, without needing
+// thread-local storage.
+const int num_host_allocation_shards = 16;
+
+struct host_allocation_shard {
+    halide_mutex mutex;
+    // The blocks in each list are linked through their first word.
+    void *free_list[num_host_size_classes];
+};
+
+WEAK host_allocation_shard host_allocation_shards[num_host_allocation_shards];
+// These are all accessed atomically, as halide_reuse_host_allocations
+// and halide_host_allocation_cache_set_size may be called while other
+// threads allocate. The sizes are pointer-sized, so that updating them
+// atomically doesn't need a library call on 32-bit targets.
+WEAK bool halide_reuse_host_allocations_flag = false;
+WEAK size_t host_allocation_cache_size = 0;
+WEAK size_t host_allocation_cache_max_size = 256 * 1024 * 1024;
+
+ALWAYS_INLINE int host_size_class(size_t x) {
+    if (x <= ((size_t)1 << host_size_class_min_log2)) {
+        return 0;
+    }
+    uint64_t y = (uint64_t)x - 1;
+    int lg = 63 - __builtin_clzll(y);
+    int quarter = (int)(y >> (lg - 2)) & 3;
+    return (lg - host_size_class_min_log2) * 4 + quarter + 1;
+}
+
+ALWAYS_INLINE size_t host_size_class_bytes(int c) {
+    if (c == 0) {
+        return (size_t)1 << host_size_class_min_log2;
+    }
+    int lg = host_size_class_min_log2 + (c - 1) / 4;
+    return ((size_t)1 << lg) + ((size_t)((c - 1) % 4 + 1) << (lg - 2));
+}
+
+ALWAYS_INLINE host_allocation_shard &current_host_allocation_shard() {
+    int on_stack;
+    uint32_t h = (uint32_t)((uintptr_t)&on_stack >> 16) * 2654435769u;
+    return host_allocation_shards[h >> 28];
+}
+
+// The layout of an allocation from halide_default_malloc: the pointer
+// returned by malloc, and the size class of the block (or -1 if it
+// isn't cached when freed) are stored just before the aligned pointer.
+ALWAYS_INLINE void *&host_allocation_orig(void *ptr) {
+    return ((void **)ptr)[-1];
+}
+
+ALWAYS_INLINE size_t &host_allocation_class(void *ptr) {
+    return ((size_t *)ptr)[-2];
+}
+
+// Free cached blocks, largest first, until at most max_size bytes are
+// cached.
+WEAK void trim_host_allocation_cache(size_t max_size) {
+    for (int c = num_host_size_classes - 1; c >= 0; c--) {
+        for (int s = 0; s < num_host_allocation_shards; s++) {
+            if (__atomic_load_n(&host_allocation_cache_size, __ATOMIC_RELAXED) <= max_size) {
+                return;
+            }
+            host_allocation_shard &shard = host_allocation_shards[s];
+            ScopedMutexLock lock(&shard.mutex);
+            while (shard.free_list[c] &&
+                   __atomic_load_n(&host_allocation_cache_size, __ATOMIC_RELAXED) > max_size) {
+                void *ptr = shard.free_list[c];
+                shard.free_list[c] = *(void **)ptr;
+                __atomic_sub_fetch(&host_allocation_cache_size, host_size_class_bytes(c), __ATOMIC_RELAXED);
+                free(host_allocation_orig(ptr));
+            }
+        }
+    }
+}
+
+}  // namespace Internal
+}  // namespace Runtime
+}  // namespace Halide
+
+extern "C" {
 
 WEAK void *halide_default_malloc(void *user_context, size_t x) {
+    size_t size_class = (size_t)-1;
+    if (__atomic_load_n(&halide_reuse_host_allocations_flag, __ATOMIC_RELAXED) &&
+        x <= ((size_t)1 << host_size_class_max_log2)) {
+        int c = host_size_class(x);
+        host_allocation_shard &shard = current_host_allocation_shard();
+        {
+            ScopedMutexLock lock(&shard.mutex);
+            void *ptr = shard.free_list[c];
+            if (ptr) {
+                shard.free_list[c] = *(void **)ptr;
+                __atomic_sub_fetch(&host_allocation_cache_size, host_size_class_bytes(c), __ATOMIC_RELAXED);
+                return ptr;
+            }
+        }
+        size_class = c;
+        x = host_size_class_bytes(c);
+    }
+
     // Allocate enough space for aligning the pointer we return.
     const size_t alignment = halide_malloc_alignment();
     void *orig = malloc(x + alignment);
@@ -16,14 +133,47 @@ WEAK void *halide_default_malloc(void *user_context, size_t x) {
         // Will result in a failed assertion and a call to halide_error
         return NULL;
     }
-    // We want to store the original pointer prior to the pointer we return.
-    void *ptr = (void *)(((size_t)orig + alignment + sizeof(void *) - 1) & ~(alignment - 1));
-    ((void **)ptr)[-1] = orig;
+    // We want to store the original pointer and the size class prior
+    // to the pointer we return.
+    void *ptr = (void *)(((size_t)orig + alignment + 2 * sizeof(void *) - 1) & ~(alignment - 1));
+    host_allocation_orig(ptr) = orig;
+    host_allocation_class(ptr) = size_class;
     return ptr;
 }
 
 WEAK void halide_default_free(void *user_context, void *ptr) {
-    free(((void **)ptr)[-1]);
+    size_t size_class = host_allocation_class(ptr);
+    if (size_class != (size_t)-1 &&
+        __atomic_load_n(&halide_reuse_host_allocations_flag, __ATOMIC_RELAXED)) {
+        size_t bytes = host_size_class_bytes((int)size_class);
+        if (__atomic_add_fetch(&host_allocation_cache_size, bytes, __ATOMIC_RELAXED) <=
+            __atomic_load_n(&host_allocation_cache_max_size, __ATOMIC_RELAXED)) {
+            host_allocation_shard &shard = current_host_allocation_shard();
+            ScopedMutexLock lock(&shard.mutex);
+            *(void **)ptr = shard.free_list[size_class];
+            shard.free_list[size_class] = ptr;
+            return;
+        }
+        __atomic_sub_fetch(&host_allocation_cache_size, bytes, __ATOMIC_RELAXED);
+    }
+    free(host_allocation_orig(ptr));
+}
+
+WEAK int halide_reuse_host_allocations(void *user_context, bool flag) {
+    __atomic_store_n(&halide_reuse_host_allocations_flag, flag, __ATOMIC_RELAXED);
+    if (!flag) {
+        trim_host_allocation_cache(0);
+    }
+    return 0;
+}
+
+WEAK void halide_host_allocation_cache_set_size(int64_t size) {
+    size_t max_size = 0;
+    if (size > 0) {
+        max_size = (uint64_t)size > (uint64_t)(size_t)-1 ? (size_t)-1 : (size_t)size;
+    }
+    __atomic_store_n(&host_allocation_cache_max_size, max_size, __ATOMIC_RELAXED);
+    trim_host_allocation_cache(max_size);
 }
 }
 
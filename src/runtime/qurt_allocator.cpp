@@ -87,6 +87,15 @@ WEAK void halide_default_free(void *user_context, void *ptr) {
     aligned_free(ptr);
 }
 
+// Small allocations are already pooled above, so there is no
+// size-class cache here.
+WEAK int halide_reuse_host_allocations(void *user_context, bool flag) {
+    return 0;
+}
+
+WEAK void halide_host_allocation_cache_set_size(int64_t size) {
+}
+
 namespace Halide {
 namespace Runtime {
 namespace Internal {
@@ -0,0 +1,12 @@
+#include <pthread.h>
+#include <stdlib.h>
+#include <stdio.h>
+extern "C" {
+struct halide_mutex { void *p[1]; };
+static pthread_mutex_t m = PTHREAD_MUTEX_INITIALIZER;
+void halide_mutex_lock(halide_mutex *) { pthread_mutex_lock(&m); }
+void halide_mutex_unlock(halide_mutex *) { pthread_mutex_unlock(&m); }
+int halide_malloc_alignment() { return 128; }
+void halide_print(void*, const char *s) { printf("%s", s); }
+void halide_error(void*, const char *s) { printf("%s", s); abort(); }
+}
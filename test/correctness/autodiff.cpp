@@ -1390,6 +1390,55 @@ void test_custom_adjoint_buffer() {
     check(__LINE__, d_input_buf(2), d_blur_buf(1));
 }
 
+void test_checkpoints() {
+    Var x("x");
+    Buffer<float> input(8);
+    for (int i = 0; i < 8; i++) {
+        input(i) = i / 8.f;
+    }
+    Func a("a"), b("b"), c("c"), loss("loss");
+    a(x) = sin(input(x));
+    b(x) = a(x) * a(x);
+    c(x) = b(x) * a(x);
+    RDom r(0, 8);
+    loss() += c(r);
+
+    // Store everything
+    Buffer<float> d_stored = propagate_adjoints(loss)(input).realize(8);
+
+    // Only store b, and recompute a
+    GradientCheckpoints checkpoints;
+    checkpoints.funcs = {b};
+    Func d_input = propagate_adjoints(loss, checkpoints)(input);
+    std::map<std::string, Function> env = find_transitive_calls(d_input.function());
+    // The copy has a unique name, so it can't clash with a Func of the
+    // user's, or with the copy made by another call.
+    int copies_of_a = 0;
+    for (const auto &it : env) {
+        copies_of_a += (it.first.find("a_recompute") == 0);
+    }
+    _halide_user_assert(env.count("b") && !env.count("a") && copies_of_a == 1)
+        << "Expected the derivatives to call b and a copy of a\n";
+    Buffer<float> d_recomputed = d_input.realize(8);
+
+    // A budget too small for any pure Func recomputes all of them
+    checkpoints.funcs.clear();
+    checkpoints.memory_budget = 0;
+    d_input = propagate_adjoints(loss, checkpoints)(input);
+    env = find_transitive_calls(d_input.function());
+    _halide_user_assert(!env.count("a") && !env.count("b") && !env.count("c"))
+        << "Expected the derivatives to recompute every pure Func\n";
+    Buffer<float> d_budget = d_input.realize(8);
+
+    for (int i = 0; i < 8; i++) {
+        // d loss / d input = 3 sin(x)^2 cos(x)
+        float expected = 3.f * std::sin(input(i)) * std::sin(input(i)) * std::cos(input(i));
+        check(__LINE__, d_stored(i), expected, 1e-5f);
+        check(__LINE__, d_recomputed(i), expected, 1e-5f);
+        check(__LINE__, d_budget(i), expected, 1e-5f);
+    }
+}
+
 void test_print() {
     Buffer<float> input(1);
     input(0) = rand();
@@ -1457,6 +1506,7 @@ int main(int argc, char **argv) {
     test_select_guard();
     test_param();
     test_custom_adjoint_buffer();
+    test_checkpoints();
     test_print();
     test_random_float();
     printf("[autodiff] Success!\n");
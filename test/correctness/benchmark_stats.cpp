@@ -0,0 +1,132 @@
+#include "halide_benchmark.h"
+#include "halide_test_dirs.h"
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+using namespace Halide::Tools;
+
+// Check the statistics, JSON reporting, and comparison of benchmark
+// samples in halide_benchmark.h that HalideBenchmarkCompare relies on.
+
+namespace {
+
+void set_env(const char *name, const char *value) {
+#ifdef _WIN32
+    _putenv_s(name, value);
+#else
+    setenv(name, value, 1);
+#endif
+}
+
+// 51 samples spread evenly over [0.99, 1.01], in a scrambled order.
+std::vector<double> noisy_samples(double scale) {
+    std::vector<double> v;
+    for (int i = 0; i < 51; i++) {
+        v.push_back(scale * (1 + 0.01 * ((i * 7) % 51 - 25) / 25));
+    }
+    return v;
+}
+
+bool near(double a, double b) {
+    return std::abs(a - b) < 1e-9;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    // Medians of odd and even numbers of samples.
+    if (BenchmarkInternal::median_of({3, 1, 2}) != 2 ||
+        BenchmarkInternal::median_of({4, 1, 3, 2}) != 2.5) {
+        printf("median_of is wrong\n");
+        return -1;
+    }
+
+    // One sample far from the rest is an outlier, and doesn't move the
+    // median or the MAD much.
+    BenchmarkStats stats = compute_benchmark_stats({1, 2, 3, 4, 100}, 8);
+    if (stats.min != 1 || !near(stats.mean, 22) || stats.median != 3 || stats.mad != 1 ||
+        stats.outliers != 1 || stats.iterations_per_sample != 8) {
+        printf("Wrong stats: min %f mean %f median %f mad %f outliers %d\n",
+               stats.min, stats.mean, stats.median, stats.mad, stats.outliers);
+        return -1;
+    }
+    if (!(stats.median_low <= stats.median && stats.median <= stats.median_high) ||
+        stats.median_low < 1 || stats.median_high > 100) {
+        printf("Bad confidence interval [%f, %f] for a median of %f\n",
+               stats.median_low, stats.median_high, stats.median);
+        return -1;
+    }
+
+    // Reporting appends one line of JSON per benchmark to
+    // HL_BENCHMARK_JSON, which reads back to the same samples.
+    const std::string json = Halide::Internal::get_test_tmp_dir() + "benchmark_stats.json";
+    std::remove(json.c_str());
+    set_env("HL_BENCHMARK_JSON", "");
+    report_benchmark_stats("not reported", stats);
+    set_env("HL_BENCHMARK_JSON", json.c_str());
+    report_benchmark_stats("quoted \"name\"", stats);
+    set_env("HL_BENCHMARK_NAME", "unnamed");
+    BenchmarkInternal::report_benchmark_samples("", {0.5, 0.25}, 1);
+    BenchmarkInternal::report_benchmark_samples("", {0.125}, 1);
+    report_benchmark_stats("quoted \"name\"", compute_benchmark_stats({7}));
+    set_env("HL_BENCHMARK_JSON", "");
+
+    std::map<std::string, std::vector<double>> results;
+    if (!load_benchmark_samples(json, &results)) {
+        printf("Nothing was written to %s\n", json.c_str());
+        return -1;
+    }
+    const std::map<std::string, std::vector<double>> expected = {
+        {"quoted \"name\"", {1, 2, 3, 4, 100, 7}},
+        {"unnamed/0", {0.5, 0.25}},
+        {"unnamed/1", {0.125}}};
+    if (results != expected) {
+        printf("Read back the wrong benchmarks from %s:\n", json.c_str());
+        for (const auto &it : results) {
+            printf("  %s: %d samples\n", it.first.c_str(), (int)it.second.size());
+        }
+        return -1;
+    }
+    std::remove(json.c_str());
+
+    if (load_benchmark_samples(json, &results)) {
+        printf("Loading a missing file should fail\n");
+        return -1;
+    }
+
+    // The regression decision, at the default 5% threshold used by
+    // HalideBenchmarkCompare.
+    const std::vector<double> baseline = noisy_samples(1);
+    struct {
+        double scale;
+        bool regression, improvement;
+    } cases[] = {
+        {1.0, false, false},
+        {1.03, false, false},
+        {0.97, false, false},
+        {1.2, true, false},
+        {0.8, false, true},
+    };
+    for (const auto &c : cases) {
+        BenchmarkComparison cmp = compare_benchmark_samples(baseline, noisy_samples(c.scale));
+        if (!near(cmp.ratio, c.scale) || cmp.ratio_low > cmp.ratio || cmp.ratio_high < cmp.ratio ||
+            cmp.regression(0.05) != c.regression || cmp.improvement(0.05) != c.improvement) {
+            printf("Comparing against %fx the baseline: ratio %f in [%f, %f], regression %d, improvement %d\n",
+                   c.scale, cmp.ratio, cmp.ratio_low, cmp.ratio_high,
+                   cmp.regression(0.05), cmp.improvement(0.05));
+            return -1;
+        }
+    }
+
+    // Identical samples aren't a significant difference.
+    if (compare_benchmark_samples(baseline, baseline).significant()) {
+        printf("Identical samples compare as significantly different\n");
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
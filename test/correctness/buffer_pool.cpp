@@ -0,0 +1,149 @@
+#include "Halide.h"
+
+#include <thread>
+
+using namespace Halide;
+
+int main(int argc, char **argv) {
+    // Same-size allocations reuse released memory.
+    {
+        Runtime::BufferPool pool;
+        void *first;
+        {
+            Runtime::Buffer<float> a(nullptr, 100, 100);
+            a.allocate(pool);
+            first = a.data();
+            if ((uintptr_t)first % 128 != 0) {
+                printf("Pooled allocation is not aligned\n");
+                return -1;
+            }
+            a.fill(1.0f);
+        }
+        if (pool.idle_bytes() < 100 * 100 * sizeof(float)) {
+            printf("Released buffer was not returned to the pool\n");
+            return -1;
+        }
+
+        Runtime::Buffer<float> b(nullptr, 100, 100);
+        b.allocate(pool);
+        if (b.data() != first || pool.idle_bytes() != 0) {
+            printf("Same-size allocation did not reuse the released buffer\n");
+            return -1;
+        }
+
+        // A different size gets fresh memory.
+        Runtime::Buffer<float> c(nullptr, 50, 100);
+        c.allocate(pool);
+        if (c.data() == first) {
+            printf("Different-size allocation reused a live buffer\n");
+            return -1;
+        }
+
+        // Memory shared between Buffers is only released with the last of them.
+        Runtime::Buffer<float> d = b;
+        b = Runtime::Buffer<float>();
+        if (pool.idle_bytes() != 0) {
+            printf("Buffer was released while still in use\n");
+            return -1;
+        }
+    }
+
+    // The pool keeps at most max_idle_bytes.
+    {
+        const size_t size = 64 * 64 * sizeof(uint8_t) * 4;
+        Runtime::BufferPool pool(2 * size);
+        {
+            std::vector<Runtime::Buffer<uint8_t>> bufs;
+            for (int i = 0; i < 5; i++) {
+                bufs.emplace_back(nullptr, 64, 64, 4);
+                bufs.back().allocate(pool);
+            }
+        }
+        if (pool.idle_bytes() != 2 * size) {
+            printf("Pool kept %d bytes instead of %d\n", (int)pool.idle_bytes(), (int)(2 * size));
+            return -1;
+        }
+        pool.set_max_idle_bytes(size);
+        if (pool.idle_bytes() != size) {
+            printf("Shrinking the pool did not free memory\n");
+            return -1;
+        }
+        pool.clear();
+        if (pool.idle_bytes() != 0) {
+            printf("Clearing the pool did not free memory\n");
+            return -1;
+        }
+    }
+
+    // Buffers may outlive their pool.
+    {
+        Runtime::Buffer<int> a(nullptr, 10);
+        {
+            Runtime::BufferPool pool;
+            a.allocate(pool);
+        }
+        a.fill(3);
+    }
+
+    // Checkout and release are thread-safe.
+    {
+        Runtime::BufferPool pool(1024 * 1024);
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; t++) {
+            threads.emplace_back([&pool, t]() {
+                for (int i = 0; i < 1000; i++) {
+                    Runtime::Buffer<int> a(nullptr, 16 + (i % 3), 16);
+                    a.allocate(pool);
+                    a.fill(t);
+                    Runtime::Buffer<int> b = a;
+                    if (b(3, 3) != t) {
+                        printf("Pooled buffer was shared between threads\n");
+                        abort();
+                    }
+                }
+            });
+        }
+        for (auto &th : threads) {
+            th.join();
+        }
+    }
+
+    // A Pipeline can allocate its outputs from a pool.
+    {
+        Func f;
+        Var x, y;
+        f(x, y) = x + y;
+        Pipeline p(f);
+        auto pool = std::make_shared<Runtime::BufferPool>();
+        p.set_output_buffer_pool(pool);
+
+        const void *first;
+        {
+            Buffer<int> out = p.realize(64, 64);
+            first = out.data();
+        }
+        for (int frame = 0; frame < 10; frame++) {
+            Buffer<int> out = p.realize(64, 64);
+            if (out.data() != first) {
+                printf("realize did not reuse the pooled output\n");
+                return -1;
+            }
+            out.for_each_element([&](int x, int y) {
+                if (out(x, y) != x + y) {
+                    printf("out(%d, %d) = %d instead of %d\n", x, y, out(x, y), x + y);
+                    abort();
+                }
+            });
+        }
+
+        p.set_output_buffer_pool(nullptr);
+        Buffer<int> out = p.realize(64, 64);
+        if (pool->idle_bytes() == 0) {
+            printf("realize used the pool after it was unset\n");
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Check that Target::FuseSiblings fuses the loops of sibling Funcs that
+// read a common compute_root producer, leaves alone the ones it can't
+// legally fuse, and doesn't change the results either way.
+
+class CountFusedLoops : public IRMutator {
+    using IRMutator::visit;
+
+    Stmt visit(const For *op) override {
+        if (op->name.find(".fused.") != std::string::npos) {
+            count++;
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    int count = 0;
+};
+
+const int W = 67, H = 43;
+
+enum Scenario {
+    // Two outputs of the same size that read the same producer.
+    MultipleOutputs,
+    // Two intermediates of different sizes consumed by one output.
+    Intermediates,
+    // The second sibling also reads the first, so they can't be fused.
+    Dependent,
+    // The siblings' rows are split differently, so they can't be fused.
+    MismatchedSplits,
+};
+
+// Realize the pipeline for a scenario into out_1 and out_2, and return
+// the number of fused loops in the lowered code.
+int run(Scenario scenario, const Target &t, Buffer<int> &out_1, Buffer<int> &out_2) {
+    Var x("x"), y("y"), yo("yo"), yi("yi");
+    Func producer("producer"), f("f"), g("g");
+
+    producer(x, y) = x * 3 + y * 5;
+    f(x, y) = producer(x, y) + producer(x + 1, y);
+    if (scenario == Dependent) {
+        g(x, y) = producer(x, y + 1) * 2 + f(x, y);
+    } else {
+        g(x, y) = producer(x, y + 1) * 2 - x;
+    }
+
+    producer.compute_root().vectorize(x, 8);
+    f.vectorize(x, 8);
+    g.vectorize(x, 8);
+    if (scenario == MismatchedSplits) {
+        f.split(y, yo, yi, 4).parallel(yo);
+        g.split(y, yo, yi, 8).parallel(yo);
+    } else {
+        f.parallel(y);
+        g.parallel(y);
+    }
+
+    CountFusedLoops counter;
+    if (scenario == Intermediates) {
+        Func out("out");
+        f.compute_root();
+        g.compute_root();
+        out(x, y) = f(x, y) + g(x + 2, y);
+        out.add_custom_lowering_pass(&counter, []() {});
+        out.realize(out_1, t);
+        out_2.fill(0);
+    } else {
+        Pipeline p({f, g});
+        p.add_custom_lowering_pass(&counter, []() {});
+        p.realize({out_1, out_2}, t);
+    }
+    return counter.count;
+}
+
+bool test(Scenario scenario, bool expect_fused) {
+    Target t = get_jit_target_from_environment();
+    Buffer<int> ref_1(W, H), ref_2(W, H), out_1(W, H), out_2(W, H);
+
+    run(scenario, t.without_feature(Target::FuseSiblings), ref_1, ref_2);
+    int fused = run(scenario, t.with_feature(Target::FuseSiblings), out_1, out_2);
+
+    if ((fused > 0) != expect_fused) {
+        printf("Scenario %d: expected %s, but found %d fused loops\n",
+               scenario, expect_fused ? "fused loops" : "no fused loops", fused);
+        return false;
+    }
+
+    for (int y = 0; y < H; y++) {
+        for (int x = 0; x < W; x++) {
+            if (out_1(x, y) != ref_1(x, y) || out_2(x, y) != ref_2(x, y)) {
+                printf("Scenario %d: result at (%d, %d) is (%d, %d) instead of (%d, %d)\n",
+                       scenario, x, y, out_1(x, y), out_2(x, y), ref_1(x, y), ref_2(x, y));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (!test(MultipleOutputs, true) ||
+        !test(Intermediates, true) ||
+        !test(Dependent, false) ||
+        !test(MismatchedSplits, false)) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -415,6 +415,25 @@ int main(int argc, char **argv) {
         assert(b.dim(3).stride() == b2.dim(3).stride());
     }
 
+    {
+        // Dense copies take the memcpy path in copy_from. This test
+        // links neither libHalide nor a Halide runtime, so it also
+        // checks that the serial copy_from and fill don't need
+        // halide_do_par_for.
+        Buffer<uint16_t> a(300, 200, 3);
+        a.fill([](int x, int y, int c) { return (uint16_t)(x + y * 3 + c * 7); });
+        Buffer<uint16_t> b(300, 200, 3);
+        b.fill(0);
+        b.copy_from(a);
+        check_equal(a, b);
+
+        Buffer<void> a_void(a);
+        Buffer<uint16_t> c(a.copy());
+        c.fill(0);
+        c.copy_from(a_void);
+        check_equal(a, c);
+    }
+
     printf("Success!\n");
     return 0;
 }
@@ -1,8 +1,10 @@
 #include "Halide.h"
 #include "halide_image_io.h"
+#include "halide_image_io_mapped.h"
 #include "halide_test_dirs.h"
 
 #include <fstream>
+#include <functional>
 
 using namespace Halide;
 
@@ -20,6 +22,17 @@ void test_round_trip(Buffer<T> buf, std::string format) {
     // Reload it
     Buffer<T> reloaded = Tools::load_image(filename);
 
+    // Formats with a raw payload can also be mapped, which should give the same values
+    if (format == "tmp" || format == "mat" || format == "npy") {
+        Buffer<T> mapped = Tools::load_mapped_image(filename);
+        reloaded.for_each_element([&](const int *pos) {
+            if (mapped(pos) != reloaded(pos)) {
+                printf("test_round_trip: Mapped %s file differs from loaded one\n", format.c_str());
+                abort();
+            }
+        });
+    }
+
     // Ensure that reloaded has the same origin as buf
     for (int d = 0; d < buf.dimensions(); ++d) {
         reloaded.translate(d, buf.dim(d).min() - reloaded.dim(d).min());
@@ -185,7 +198,7 @@ void do_test() {
     luma_buf.copy_from(color_buf);
     luma_buf.slice(2);
 
-    std::vector<std::string> formats = {"ppm", "pgm", "tmp", "mat", "tiff"};
+    std::vector<std::string> formats = {"ppm", "pgm", "tmp", "mat", "npy", "tiff"};
 #ifndef HALIDE_NO_JPEG
     formats.push_back("jpg");
 #endif
@@ -255,10 +268,166 @@ void test_mat_header() {
     }
 }
 
+void test_mapped() {
+    Buffer<uint16_t> buf(31, 17, 3);
+    buf.for_each_element([&](int x, int y, int c) { buf(x, y, c) = x + y * 100 + c * 10000; });
+    std::string filename = Internal::get_test_tmp_dir() + "test_mapped.npy";
+    Tools::save_image(buf, filename);
+
+    // Writes to a mapped image must not reach the file
+    Buffer<uint16_t> mapped = Tools::load_mapped_image(filename);
+    Buffer<uint16_t> loaded = Tools::load_image(filename);
+    mapped.fill(0);
+    Buffer<uint16_t> remapped = Tools::load_mapped_image(filename);
+    remapped.for_each_element([&](const int *pos) {
+        if (remapped(pos) != buf(pos) || loaded(pos) != buf(pos)) {
+            printf("test_mapped: Mapped file was modified through the image\n");
+            abort();
+        }
+    });
+
+    std::ifstream fs(filename.c_str(), std::ifstream::binary);
+    std::string contents((std::istreambuf_iterator<char>(fs)), std::istreambuf_iterator<char>());
+    fs.close();
+
+    // A file too short for its payload fails to map (and to load)
+    std::string truncated_filename = Internal::get_test_tmp_dir() + "test_mapped_truncated.npy";
+    std::ofstream(truncated_filename.c_str(), std::ofstream::binary) << contents.substr(0, contents.size() - 2);
+    Buffer<uint16_t> truncated;
+    if (Tools::load_mapped(truncated_filename, &truncated) ||
+        Tools::load(truncated_filename, &truncated)) {
+        printf("test_mapped: Truncated file was loaded\n");
+        abort();
+    }
+
+    // So does one with a corrupted header
+    std::string malformed_filename = Internal::get_test_tmp_dir() + "test_mapped_malformed.npy";
+    std::string malformed = contents;
+    malformed[1] = 'X';
+    std::ofstream(malformed_filename.c_str(), std::ofstream::binary) << malformed;
+    Buffer<uint16_t> malformed_buf;
+    if (Tools::load_mapped(malformed_filename, &malformed_buf)) {
+        printf("test_mapped: Malformed file was mapped\n");
+        abort();
+    }
+}
+
+void test_tiled(const std::string &ext) {
+    // Tiles split x and y, but each covers all the channels.
+    const int width = 200, height = 150, channels = 3;
+    Buffer<float> input(width, height, channels);
+    input.for_each_element([&](int x, int y, int c) { input(x, y, c) = x * 1000.0f + y + c * 0.25f; });
+    std::string in_filename = Internal::get_test_tmp_dir() + "test_tiled_in." + ext;
+    std::string out_filename = Internal::get_test_tmp_dir() + "test_tiled_out." + ext;
+    Tools::save_image(input, in_filename);
+
+    ImageParam in(Float(32), 3);
+    Func clamped = BoundaryConditions::repeat_edge(in, {{0, width}, {0, height}, {0, channels}});
+    Func blur;
+    Var x, y, c;
+    blur(x, y, c) = clamped(x - 1, y, c) + clamped(x + 1, y + 1, 2 - c);
+    Pipeline p(blur);
+
+    int writer_dims = 0;
+    {
+        // The output file is complete once the writer is closed.
+        Tools::TiledImageReader<Tools::Internal::CheckFail> reader(in_filename);
+        Tools::TiledImageWriter<Tools::Internal::CheckFail> writer(out_filename, Float(32), {width, height, channels});
+        Tools::realize_tiled(p, in, reader, writer, {64, 64});
+        writer_dims = (int)writer.extents().size();
+    }
+
+    // The tiles are the shape the writer was given, even though a .tmp
+    // file always has four dimensions on disk.
+    if (writer_dims != 3) {
+        printf("test_tiled: the %s writer has %d dimensions\n", ext.c_str(), writer_dims);
+        abort();
+    }
+
+    Buffer<float> output = Tools::load_image(out_filename);
+    if (ext == "tmp") {
+        if (output.dimensions() != 4 || output.dim(3).extent() != 1) {
+            printf("test_tiled: .tmp output has %d dimensions\n", output.dimensions());
+            abort();
+        }
+        output = output.sliced(3);
+    }
+    if (output.dimensions() != 3 || output.channels() != channels) {
+        printf("test_tiled: output has %d dimensions and %d channels\n", output.dimensions(), output.channels());
+        abort();
+    }
+    output.for_each_element([&](int x, int y, int c) {
+        float correct = (input(std::max(x - 1, 0), y, c) +
+                         input(std::min(x + 1, width - 1), std::min(y + 1, height - 1), 2 - c));
+        if (output(x, y, c) != correct) {
+            printf("test_tiled: %s output(%d, %d, %d) = %f instead of %f\n", ext.c_str(), x, y, c, output(x, y, c), correct);
+            abort();
+        }
+    });
+}
+
+template<typename T>
+void check_npy(const std::string &name, const std::vector<int> &extents, std::function<T(int, int)> correct) {
+    const std::string filename = std::string(IMAGE_IO_NPY_DIR) + name;
+    Buffer<T> buf = Tools::load_image(filename);
+    if (buf.dimensions() != (int)extents.size()) {
+        printf("test_npy_fixtures: %s has %d dimensions instead of %d\n", name.c_str(), buf.dimensions(), (int)extents.size());
+        abort();
+    }
+    for (int d = 0; d < buf.dimensions(); d++) {
+        if (buf.dim(d).extent() != extents[d]) {
+            printf("test_npy_fixtures: %s has extent %d in dimension %d instead of %d\n",
+                   name.c_str(), buf.dim(d).extent(), d, extents[d]);
+            abort();
+        }
+    }
+
+    // The same region read in tiles, which handles byte order and
+    // layout separately from load_image.
+    Buffer<T> tile(extents);
+    {
+        Tools::TiledImageReader<Tools::Internal::CheckFail> reader(filename);
+        reader.read(tile);
+    }
+
+    buf.for_each_element([&](const int *pos) {
+        const int x = pos[0], y = buf.dimensions() > 1 ? pos[1] : 0;
+        if (buf(pos) != correct(x, y) || tile(pos) != correct(x, y)) {
+            printf("test_npy_fixtures: %s(%d, %d) is %f loaded and %f read in tiles instead of %f\n",
+                   name.c_str(), x, y, (double)buf(pos), (double)tile(pos), (double)correct(x, y));
+            abort();
+        }
+    });
+}
+
+// Read .npy files written by numpy with features save_image never
+// produces. See image_io_npy/make_fixtures.py.
+void test_npy_fixtures() {
+    // A column-major array keeps numpy's order of dimensions, so x is
+    // numpy's first index.
+    check_npy<int16_t>("fortran_order.npy", {3, 4}, [](int x, int y) { return (int16_t)(10 * x + y); });
+
+    // Otherwise the dimensions are reversed, so x is numpy's last index.
+    const int32_t ints[2][3] = {{1, -2, 0x01020304}, {-0x01020304, 0, 0x7fffffff}};
+    check_npy<int32_t>("big_endian_i4.npy", {3, 2}, [&](int x, int y) { return ints[y][x]; });
+    const double doubles[3] = {0.5, -1.25, 1e300};
+    check_npy<double>("big_endian_f8.npy", {3}, [&](int x, int y) { return doubles[x]; });
+
+    const bool bools[2][3] = {{true, false, false}, {false, true, true}};
+    check_npy<bool>("bool.npy", {3, 2}, [&](int x, int y) { return bools[y][x]; });
+
+    const float halfs[2][2] = {{1.5f, -2.0f}, {0.25f, 65504.0f}};
+    check_npy<float16_t>("float16.npy", {2, 2}, [&](int x, int y) { return float16_t(halfs[y][x]); });
+}
+
 int main(int argc, char **argv) {
     do_test<uint8_t>();
     do_test<uint16_t>();
     test_mat_header();
+    test_mapped();
+    test_npy_fixtures();
+    test_tiled("npy");
+    test_tiled("tmp");
     printf("Success!\n");
     return 0;
 }
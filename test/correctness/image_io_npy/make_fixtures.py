@@ -0,0 +1,15 @@
+# Writes the .npy files read by test/correctness/image_io.cpp. The
+# values must match the ones the test expects.
+import numpy as np
+
+# A 3x4 array stored column-major. Its element [i, j] is 10 * i + j.
+np.save("fortran_order.npy",
+        np.asfortranarray(np.fromfunction(lambda i, j: 10 * i + j, (3, 4), dtype=np.int16)))
+
+# Big-endian ints and doubles, byte-swapped on little-endian machines.
+np.save("big_endian_i4.npy", np.array([[1, -2, 0x01020304], [-0x01020304, 0, 2**31 - 1]], dtype=">i4"))
+np.save("big_endian_f8.npy", np.array([0.5, -1.25, 1e300], dtype=">f8"))
+
+np.save("bool.npy", np.array([[True, False, False], [False, True, True]]))
+
+np.save("float16.npy", np.array([[1.5, -2.0], [0.25, 65504.0]], dtype=np.float16))
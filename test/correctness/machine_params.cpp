@@ -0,0 +1,63 @@
+#include "Halide.h"
+#include <stdio.h>
+#include <thread>
+
+using namespace Halide;
+
+bool same(const MachineParams &a, const MachineParams &b) {
+    return (a.parallelism == b.parallelism &&
+            a.last_level_cache_size == b.last_level_cache_size &&
+            a.balance == b.balance &&
+            a.l1_cache_size == b.l1_cache_size &&
+            a.l2_cache_size == b.l2_cache_size &&
+            a.vector_width == b.vector_width &&
+            a.cores_per_numa_node == b.cores_per_numa_node);
+}
+
+int main(int argc, char **argv) {
+    // The three-field form is unchanged, and leaves the rest unknown.
+    MachineParams p("16,16777216,40");
+    if (p.parallelism != 16 || p.last_level_cache_size != 16777216 || p.balance != 40 ||
+        p.l1_cache_size != 0 || p.l2_cache_size != 0 ||
+        p.vector_width != 0 || p.cores_per_numa_node != 0) {
+        printf("Failed to parse three-field MachineParams\n");
+        return -1;
+    }
+    if (p.to_string() != "16,16777216,40") {
+        printf("Three-field MachineParams printed as %s\n", p.to_string().c_str());
+        return -1;
+    }
+
+    // The seven-field form round-trips.
+    MachineParams q("8,33554432,40,32768,1048576,64,4");
+    if (q.l1_cache_size != 32768 || q.l2_cache_size != 1048576 ||
+        q.vector_width != 64 || q.cores_per_numa_node != 4) {
+        printf("Failed to parse seven-field MachineParams\n");
+        return -1;
+    }
+    if (!same(q, MachineParams(q.to_string()))) {
+        printf("MachineParams %s did not round-trip\n", q.to_string().c_str());
+        return -1;
+    }
+
+    // Whatever the host reports must be usable and round-trip.
+    MachineParams h = MachineParams::host();
+    if (h.parallelism < 1 || h.last_level_cache_size <= 0 || h.balance <= 0) {
+        printf("Host MachineParams are invalid: %s\n", h.to_string().c_str());
+        return -1;
+    }
+    // Hyperthreads don't add to the parallelism, so there are never
+    // more cores than logical CPUs.
+    const int cpus = (int)std::thread::hardware_concurrency();
+    if (cpus > 0 && (h.parallelism > cpus || h.cores_per_numa_node > h.parallelism)) {
+        printf("Host MachineParams %s claim more cores than the %d CPUs\n", h.to_string().c_str(), cpus);
+        return -1;
+    }
+    if (!same(h, MachineParams(h.to_string())) || !same(h, MachineParams("host"))) {
+        printf("Host MachineParams %s did not round-trip\n", h.to_string().c_str());
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
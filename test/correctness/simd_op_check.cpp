@@ -455,6 +455,11 @@ public:
             }
             check("vpmulld*ymm", 8, i32_1 * i32_2);
 
+            // Data-dependent loads of 32- and 64-bit values use hardware gathers
+            check("vpgatherdd*ymm", 8, in_i32(i32(u8_1)));
+            check("vgatherdps*ymm", 8, in_f32(i32(u8_1)));
+            check("vpgatherdq*ymm", 4, in_i64(i32(u8_1)));
+
             if (use_avx512) {
                 // avx512 does vector blends with a mov + predicate register
                 check("vmov*%k", 32, select(u8_1 > 7, u8_1, u8_2));
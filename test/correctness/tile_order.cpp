@@ -0,0 +1,131 @@
+#include "Halide.h"
+#include <stdio.h>
+
+#include <cstdlib>
+#include <vector>
+
+using namespace Halide;
+
+// Check that tiles traversed along a space-filling curve cover every
+// point exactly once, in the expected order.
+
+std::vector<std::pair<int, int>> visited;
+
+int my_trace(void *user_context, const halide_trace_event_t *e) {
+    if (e->event == halide_trace_store) {
+        visited.emplace_back(e->coordinates[0], e->coordinates[1]);
+    }
+    return 0;
+}
+
+// Schedule f with tiles of size tile_w x tile_h in the given order, and
+// check that it stores each point of a w x h image exactly once.
+bool test_coverage(TileOrder order, int w, int h, int tile_w, int tile_h) {
+    Func f("f");
+    Var x("x"), y("y"), t("t"), xi("xi"), yi("yi");
+    f(x, y) = x + y * 1000;
+    f.tile(x, y, t, xi, yi, tile_w, tile_h, order, TailStrategy::GuardWithIf);
+    f.trace_stores();
+    f.set_custom_trace(&my_trace);
+
+    visited.clear();
+    Buffer<int> out = f.realize(w, h);
+
+    std::vector<int> count(w * h, 0);
+    for (const auto &p : visited) {
+        if (p.first < 0 || p.first >= w || p.second < 0 || p.second >= h) {
+            printf("Order %d, %dx%d in %dx%d tiles: stored out of bounds at (%d, %d)\n",
+                   (int)order, w, h, tile_w, tile_h, p.first, p.second);
+            return false;
+        }
+        count[p.first + p.second * w]++;
+    }
+    for (int y = 0; y < h; y++) {
+        for (int x = 0; x < w; x++) {
+            if (count[x + y * w] != 1 || out(x, y) != x + y * 1000) {
+                printf("Order %d, %dx%d in %dx%d tiles: (%d, %d) stored %d times with value %d\n",
+                       (int)order, w, h, tile_w, tile_h, x, y, count[x + y * w], out(x, y));
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// With 1x1 tiles over a square power-of-two grid, check the sequence of
+// points visited.
+bool test_sequence(TileOrder order) {
+    const int n = 8;
+    Func f("f");
+    Var x("x"), y("y"), t("t");
+    f(x, y) = x + y;
+    f.fuse(x, y, t, order);
+    f.trace_stores();
+    f.set_custom_trace(&my_trace);
+
+    visited.clear();
+    f.realize(n, n);
+
+    if ((int)visited.size() != n * n) {
+        printf("Order %d: expected %d stores, got %d\n", (int)order, n * n, (int)visited.size());
+        return false;
+    }
+
+    for (int i = 0; i < n * n; i++) {
+        int x = visited[i].first, y = visited[i].second;
+        if (order == TileOrder::Morton) {
+            // x is made of the even bits of i, and y of the odd bits.
+            int ex = 0, ey = 0;
+            for (int b = 0; b < 3; b++) {
+                ex |= ((i >> (2 * b)) & 1) << b;
+                ey |= ((i >> (2 * b + 1)) & 1) << b;
+            }
+            if (x != ex || y != ey) {
+                printf("Morton order: point %d is (%d, %d) instead of (%d, %d)\n", i, x, y, ex, ey);
+                return false;
+            }
+        } else if (i > 0) {
+            // Consecutive points along a Hilbert curve are neighbours.
+            int dx = std::abs(x - visited[i - 1].first);
+            int dy = std::abs(y - visited[i - 1].second);
+            if (dx + dy != 1) {
+                printf("Hilbert order: point %d (%d, %d) is not adjacent to (%d, %d)\n",
+                       i, x, y, visited[i - 1].first, visited[i - 1].second);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    for (TileOrder order : {TileOrder::Morton, TileOrder::Hilbert}) {
+        if (!test_sequence(order)) {
+            return -1;
+        }
+
+        // Square, wide, tall, degenerate, and ragged grids of tiles.
+        if (!test_coverage(order, 64, 64, 8, 8) ||
+            !test_coverage(order, 100, 37, 8, 4) ||
+            !test_coverage(order, 19, 77, 4, 4) ||
+            !test_coverage(order, 1, 50, 1, 1) ||
+            !test_coverage(order, 45, 3, 2, 2) ||
+            !test_coverage(order, 33, 17, 5, 3)) {
+            return -1;
+        }
+
+        // Non-power-of-two numbers of tiles, including ones just past
+        // a power of two, where the padding is largest.
+        if (!test_coverage(order, 3, 3, 1, 1) ||
+            !test_coverage(order, 65, 64, 1, 1) ||
+            !test_coverage(order, 64, 65, 1, 1) ||
+            !test_coverage(order, 17, 17, 1, 1) ||
+            !test_coverage(order, 1, 1, 1, 1) ||
+            !test_coverage(order, 99, 7, 3, 1)) {
+            return -1;
+        }
+    }
+
+    printf("Success!\n");
+    return 0;
+}
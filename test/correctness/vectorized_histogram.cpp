@@ -0,0 +1,195 @@
+#include "Halide.h"
+#include <stdio.h>
+
+using namespace Halide;
+using namespace Halide::Internal;
+
+// Check that histogram-style updates with a data-dependent index
+// give the same answer when the reduction domain is vectorized
+// (with and without an outer parallel loop) as when it is serial,
+// and that they really were vectorized: into per-lane private copies
+// of the histogram when the keys are narrow enough, and into
+// conflict-resolving vector scatters otherwise.
+
+// Counts the vector scatters, how many of them go to per-lane
+// private copies, and the scalar and vector stores left inside
+// atomic nodes.
+class Checker : public IRMutator {
+    bool in_atomic = false;
+
+    Stmt visit(const Atomic *op) override {
+        bool old_in_atomic = in_atomic;
+        in_atomic = true;
+        Stmt s = IRMutator::visit(op);
+        in_atomic = old_in_atomic;
+        return s;
+    }
+
+    Stmt visit(const Store *op) override {
+        const int store_lanes = op->value.type().lanes();
+        if (store_lanes == lanes && !op->index.as<Ramp>()) {
+            scatters++;
+            if (op->name.find(".per_lane") != std::string::npos) {
+                privatized_scatters++;
+            }
+        }
+        if (in_atomic) {
+            if (store_lanes == 1) {
+                scalar_atomic_stores++;
+            } else {
+                vector_atomic_stores++;
+            }
+        }
+        return IRMutator::visit(op);
+    }
+
+public:
+    int lanes;
+    int scatters = 0;
+    int privatized_scatters = 0;
+    int scalar_atomic_stores = 0;
+    int vector_atomic_stores = 0;
+
+    Checker(int lanes)
+        : lanes(lanes) {
+    }
+};
+
+template<typename T>
+bool test(int op, int lanes, bool parallel, bool narrow_keys) {
+    const int size = 1024;
+    const int buckets = 13;
+
+    Func in, keys;
+    Var x;
+    // Use few buckets relative to the vector width, so that lots of
+    // lanes collide.
+    in(x) = cast<T>(random_int() % 100);
+    keys(x) = cast<int>(abs(random_int()) % buckets);
+    in.compute_root();
+    keys.compute_root();
+    // Keys with a small range of values, so that each lane can have
+    // its own copy of the histogram.
+    Func narrow("narrow");
+    narrow(x) = cast<uint8_t>(keys(x));
+    narrow.compute_root();
+    Func k = narrow_keys ? narrow : keys;
+
+    RDom r(0, size);
+    Func f("f"), ref("ref");
+    Expr init = (op == 2) ? cast<T>(1) : cast<T>(0);
+    f(x) = init;
+    ref(x) = init;
+
+    switch (op) {
+    case 0:
+        f(k(r)) += cast<T>(1);
+        ref(k(r)) += cast<T>(1);
+        break;
+    case 1:
+        f(k(r)) += in(r);
+        ref(k(r)) += in(r);
+        break;
+    case 2:
+        f(k(r)) *= in(r);
+        ref(k(r)) *= in(r);
+        break;
+    case 3:
+        f(k(r)) = min(f(k(r)), in(r));
+        ref(k(r)) = min(ref(k(r)), in(r));
+        break;
+    case 4:
+        f(k(r)) = max(f(k(r)), in(r));
+        ref(k(r)) = max(ref(k(r)), in(r));
+        break;
+    }
+
+    RVar ro, ri, rii;
+    if (parallel) {
+        // Leave a serial loop inside each parallel task, over which
+        // private copies can accumulate.
+        f.update().atomic().split(r, ro, ri, size / 8).split(ri, ri, rii, lanes).parallel(ro).vectorize(rii);
+    } else {
+        f.update().atomic().vectorize(r, lanes);
+    }
+
+    Checker checker(lanes);
+    f.add_custom_lowering_pass(&checker, []() {});
+
+    Buffer<T> result = f.realize(buckets);
+
+    // Outside of a parallel loop the atomics are dropped, and inside
+    // one the only scalar atomics should be those reducing the
+    // private copies into the result once per task.
+    const char *problem = nullptr;
+    if (checker.scatters == 0) {
+        problem = "the update wasn't vectorized";
+    } else if (narrow_keys && checker.privatized_scatters != checker.scatters) {
+        problem = "the update wasn't privatized";
+    } else if (narrow_keys && checker.vector_atomic_stores != 0) {
+        problem = "the privatized update still has vector atomics";
+    } else if (!narrow_keys && checker.privatized_scatters != 0) {
+        problem = "the update was privatized over a wide range of keys";
+    } else if (!narrow_keys && parallel &&
+               (checker.vector_atomic_stores == 0 || checker.scalar_atomic_stores != 0)) {
+        problem = "the parallel update wasn't a vector atomic";
+    }
+    if (problem) {
+        printf("op %d with %d lanes%s%s: %s (%d scatters, %d privatized, %d scalar and %d vector atomic stores)\n",
+               op, lanes, parallel ? " (parallel)" : "", narrow_keys ? " (narrow keys)" : "",
+               problem, checker.scatters, checker.privatized_scatters,
+               checker.scalar_atomic_stores, checker.vector_atomic_stores);
+        return false;
+    }
+    Buffer<T> correct = ref.realize(buckets);
+
+    for (int i = 0; i < buckets; i++) {
+        if (result(i) != correct(i)) {
+            printf("op %d with %d lanes%s%s: bucket %d is %f instead of %f\n",
+                   op, lanes, parallel ? " (parallel)" : "", narrow_keys ? " (narrow keys)" : "", i,
+                   (double)result(i), (double)correct(i));
+            return false;
+        }
+    }
+    return true;
+}
+
+template<typename T>
+bool test_all() {
+    for (int op = 0; op < 5; op++) {
+        if (op == 2 && type_of<T>().is_float()) {
+            // A float product depends on the order it's accumulated
+            // in, so it won't match the serial reference.
+            continue;
+        }
+        for (int lanes : {4, 8, 16}) {
+            for (bool parallel : {false, true}) {
+                for (bool narrow_keys : {false, true}) {
+                    if (!test<T>(op, lanes, parallel, narrow_keys)) {
+                        return false;
+                    }
+                }
+            }
+        }
+    }
+    return true;
+}
+
+int main(int argc, char **argv) {
+    if (get_jit_target_from_environment().arch == Target::WebAssembly) {
+        printf("[SKIP] Skipping test for WebAssembly as it does not support atomics yet.\n");
+        return 0;
+    }
+
+    if (!test_all<uint8_t>() ||
+        !test_all<int16_t>() ||
+        !test_all<int32_t>() ||
+        !test_all<uint32_t>() ||
+        !test_all<int64_t>() ||
+        !test_all<float>()) {
+        return -1;
+    }
+
+    printf("Success!\n");
+    return 0;
+}
@@ -1,13 +1,83 @@
 #include <stdio.h>
+#include <string.h>
 
 #include "HalideBuffer.h"
 #include "HalideRuntimeCuda.h"
 #include "HalideRuntimeOpenCL.h"
 #include "buffer_copy.h"
 
+#define RUN_BENCHMARKS 0
+#if RUN_BENCHMARKS
+#include "halide_benchmark.h"
+#endif
+
 using namespace Halide::Runtime;
 
 int main(int argc, char **argv) {
+    // Test the parallel host-side Buffer helpers, which run on the
+    // thread pool in the runtime linked into this test.
+    {
+        Buffer<float> input(1000, 300, 3);
+        input.for_each_element([&](int x, int y, int c) { input(x, y, c) = x + y * 1000 + c * 1000000; });
+
+        // Dense on both sides, so this is done with memcpy
+        Buffer<float> dense(1000, 300, 3);
+        dense.copy_from_parallel(input);
+
+        // A crop into an interleaved buffer, which is strided
+        Buffer<float> interleaved = Buffer<float>::make_interleaved(700, 300, 3);
+        interleaved.set_min(100, 0, 0);
+        interleaved.copy_from_parallel(input);
+
+        for (Buffer<float> out : {dense, interleaved}) {
+            out.for_each_element([&](int x, int y, int c) {
+                if (out(x, y, c) != input(x, y, c)) {
+                    printf("copy_from_parallel failed at %d %d %d\n", x, y, c);
+                    exit(-1);
+                }
+            });
+        }
+
+        Buffer<uint16_t> filled(4096, 512);
+        filled.fill_parallel(7);
+        Buffer<uint16_t> transposed(512, 4096);
+        transposed.for_each_value_parallel([](uint16_t &a, uint16_t b) { a = b + 1; },
+                                           filled.transposed(0, 1));
+        transposed.for_each_value([&](uint16_t a) {
+            if (a != 8) {
+                printf("fill_parallel or for_each_value_parallel failed\n");
+                exit(-1);
+            }
+        });
+    }
+
+#if RUN_BENCHMARKS
+    {
+        Buffer<uint8_t> input(4096, 4096, 8);
+        Buffer<uint8_t> output(4096, 4096, 8);
+        input.fill(1);
+        Buffer<uint8_t> cropped = input.cropped(0, 0, 4000);
+        const double bytes = (double)input.size_in_bytes();
+        const double cropped_bytes = (double)cropped.number_of_elements();
+
+        double t_memcpy = Halide::Tools::benchmark([&]() { memcpy(output.data(), input.data(), input.size_in_bytes()); });
+        double t_copy = Halide::Tools::benchmark([&]() { output.copy_from(input); });
+        double t_copy_parallel = Halide::Tools::benchmark([&]() { output.copy_from_parallel(input); });
+        double t_crop = Halide::Tools::benchmark([&]() { output.copy_from(cropped); });
+        double t_crop_parallel = Halide::Tools::benchmark([&]() { output.copy_from_parallel(cropped); });
+        double t_fill = Halide::Tools::benchmark([&]() { output.fill(3); });
+        double t_fill_parallel = Halide::Tools::benchmark([&]() { output.fill_parallel(3); });
+
+        printf("memcpy:                    %.3e bytes/s\n", bytes / t_memcpy);
+        printf("copy_from:                 %.3e bytes/s\n", bytes / t_copy);
+        printf("copy_from_parallel:        %.3e bytes/s\n", bytes / t_copy_parallel);
+        printf("copy_from (crop):          %.3e bytes/s\n", cropped_bytes / t_crop);
+        printf("copy_from_parallel (crop): %.3e bytes/s\n", cropped_bytes / t_crop_parallel);
+        printf("fill:                      %.3e bytes/s\n", bytes / t_fill);
+        printf("fill_parallel:             %.3e bytes/s\n", bytes / t_fill_parallel);
+    }
+#endif
+
     // Test simple host to host buffer copy.
 
     {
@@ -0,0 +1,133 @@
+#include "HalideBuffer.h"
+#include "HalideRuntime.h"
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "host_allocation_cache.h"
+
+using namespace Halide::Runtime;
+
+// Not in HalideRuntime.h, but exported by the runtime.
+extern "C" int halide_malloc_alignment();
+
+namespace {
+
+const size_t kGB = (size_t)1 << 30;
+
+// Allocate a block, and check that it's aligned and can be written.
+void *checked_malloc(size_t size) {
+    void *p = halide_malloc(nullptr, size);
+    if (p == nullptr) {
+        return nullptr;
+    }
+    if ((uintptr_t)p % halide_malloc_alignment() != 0) {
+        printf("halide_malloc(%llu) returned %p, which isn't %d-byte aligned\n",
+               (unsigned long long)size, p, halide_malloc_alignment());
+        exit(-1);
+    }
+    ((uint8_t *)p)[0] = 1;
+    ((uint8_t *)p)[size - 1] = 1;
+    return p;
+}
+
+void expect(bool ok, const char *what) {
+    if (!ok) {
+        printf("%s\n", what);
+        exit(-1);
+    }
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    halide_reuse_host_allocations(nullptr, true);
+
+    // Blocks are cached per size class: 64 bytes, then 65 to 80, then
+    // 81 to 96. A freed block is recycled for the next allocation of
+    // its class (this thread always uses the same free lists), but
+    // never for another class, because it's still in the cache.
+    void *p64 = checked_malloc(64);
+    halide_free(nullptr, p64);
+    void *p65 = checked_malloc(65);
+    expect(p65 != p64, "A 64 byte block was used for 65 bytes");
+    halide_free(nullptr, p65);
+    void *p80 = checked_malloc(80);
+    expect(p80 == p65, "A 65 byte block wasn't recycled for 80 bytes");
+    halide_free(nullptr, p80);
+    void *p81 = checked_malloc(81);
+    expect(p81 != p65 && p81 != p64, "An 81 byte allocation reused a block of a smaller class");
+    expect(checked_malloc(64) == p64, "A 64 byte block wasn't recycled");
+    halide_free(nullptr, p64);
+    halide_free(nullptr, p81);
+
+    // 1GB is the largest class that's cached; anything larger goes
+    // straight back to the system. Only the first and last bytes are
+    // touched, so this shouldn't need the memory to be resident, but
+    // skip the sizes the system won't provide at all.
+    halide_host_allocation_cache_set_size(4 * (int64_t)kGB);
+    void *p1g = checked_malloc(kGB);
+    if (p1g) {
+        halide_free(nullptr, p1g);
+        expect(checked_malloc(kGB) == p1g, "A 1GB block wasn't recycled");
+        halide_free(nullptr, p1g);
+    } else {
+        printf("Could not allocate 1GB; skipping that size\n");
+    }
+    void *p1g1 = checked_malloc(kGB + 1);
+    if (p1g1) {
+        halide_free(nullptr, p1g1);
+    } else {
+        printf("Could not allocate 1GB + 1 byte; skipping that size\n");
+    }
+
+    // Shrinking the cache frees cached blocks. The most recently freed
+    // block is at the head of its list, so it's the one trimmed. Turning
+    // reuse off and on again empties the cache first.
+    halide_reuse_host_allocations(nullptr, false);
+    halide_reuse_host_allocations(nullptr, true);
+    halide_host_allocation_cache_set_size(256 * 1024 * 1024);
+    void *a = checked_malloc(1000);
+    void *b = checked_malloc(1000);
+    halide_free(nullptr, a);
+    halide_free(nullptr, b);
+    halide_host_allocation_cache_set_size(1024);
+    void *c = checked_malloc(1000);
+    expect(c == a, "Shrinking the cache didn't free the most recently cached block");
+
+    // Reuse can be toggled with blocks outstanding. Blocks allocated
+    // while reuse is off aren't cached when freed after it's turned
+    // back on, and blocks allocated while it's on can be freed while
+    // it's off.
+    halide_host_allocation_cache_set_size(256 * 1024 * 1024);
+    void *d = checked_malloc(1000);
+    halide_reuse_host_allocations(nullptr, false);
+    void *untracked = checked_malloc(1000);
+    halide_free(nullptr, d);
+    halide_reuse_host_allocations(nullptr, true);
+    halide_free(nullptr, c);
+    halide_free(nullptr, untracked);
+    expect(checked_malloc(1000) == c, "A block allocated while reuse was off was cached");
+    halide_free(nullptr, c);
+
+    // A pipeline allocating in a loop gets the right answer while its
+    // blocks are being recycled.
+    Buffer<int32_t> input(257, 64);
+    input.for_each_element([&](int x, int y) { input(x, y) = x + y * 1000; });
+    Buffer<int32_t> output(256, 64);
+    for (int i = 0; i < 3; i++) {
+        expect(host_allocation_cache(input, output) == 0, "Running the pipeline failed");
+        output.for_each_element([&](int x, int y) {
+            int correct = 2 * input(x, y) + 2 * input(x + 1, y);
+            if (output(x, y) != correct) {
+                printf("output(%d, %d) = %d instead of %d\n", x, y, output(x, y), correct);
+                exit(-1);
+            }
+        });
+    }
+
+    halide_reuse_host_allocations(nullptr, false);
+
+    printf("Success!\n");
+    return 0;
+}
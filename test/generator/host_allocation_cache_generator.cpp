@@ -0,0 +1,23 @@
+#include "Halide.h"
+
+namespace {
+
+class HostAllocationCache : public Halide::Generator<HostAllocationCache> {
+public:
+    Input<Buffer<int32_t>> input{"input", 2};
+    Output<Buffer<int32_t>> output{"output", 2};
+
+    void generate() {
+        // A pipeline with a heap allocation per row, so that it goes
+        // through halide_malloc and halide_free many times.
+        Var x, y;
+        Func doubled;
+        doubled(x, y) = input(x, y) * 2;
+        output(x, y) = doubled(x, y) + doubled(x + 1, y);
+        doubled.compute_at(output, y);
+    }
+};
+
+}  // namespace
+
+HALIDE_REGISTER_GENERATOR(HostAllocationCache, host_allocation_cache)
@@ -1,3 +1,4 @@
+#include "ApplySplit.h"
 #include "Associativity.h"
 #include "AutoScheduleUtils.h"
 #include "Bounds.h"
@@ -38,6 +39,7 @@ int main(int argc, const char **argv) {
     cplusplus_mangle_test();
     is_monotonic_test();
     split_predicate_test();
+    apply_split_test();
     associativity_test();
     generator_test();
     propagate_estimate_test();
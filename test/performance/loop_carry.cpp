@@ -0,0 +1,125 @@
+#include "Halide.h"
+#include "halide_benchmark.h"
+
+#include <cstdio>
+
+using namespace Halide;
+using namespace Halide::Tools;
+
+// Benchmark a 1xN box filter along rows with and without
+// Target::LoopCarry, which carries the overlapping input vectors from
+// one iteration of the vectorized loop to the next instead of
+// reloading them.
+
+// Counts the vector loads of a buffer inside the loops over a given
+// variable, i.e. the loads done on every iteration of the vectorized
+// loop.
+class CountLoads : public Internal::IRMutator {
+    using Internal::IRMutator::visit;
+
+    bool in_loop = false;
+
+    Internal::Stmt visit(const Internal::For *op) override {
+        bool old_in_loop = in_loop;
+        in_loop = in_loop || Internal::ends_with(op->name, "." + var);
+        Internal::Stmt s = Internal::IRMutator::visit(op);
+        in_loop = old_in_loop;
+        return s;
+    }
+
+    Expr visit(const Internal::Load *op) override {
+        if (in_loop && op->name == buffer && op->type.is_vector()) {
+            loads++;
+        }
+        return Internal::IRMutator::visit(op);
+    }
+
+public:
+    std::string buffer, var;
+    int loads = 0;
+
+    CountLoads(const std::string &buffer, const std::string &var)
+        : buffer(buffer), var(var) {
+    }
+};
+
+Buffer<uint16_t> input;
+
+struct Result {
+    double time;
+    int loads;
+};
+
+Result run(int taps, const Target &t, Buffer<uint16_t> &out) {
+    Func in = BoundaryConditions::repeat_edge(input);
+    Func in16("in16");
+    Var x, y;
+    in16(x, y) = in(x, y);
+
+    Expr sum = cast<uint16_t>(0);
+    for (int i = 0; i < taps; i++) {
+        sum += in16(x + i, y);
+    }
+    Func blur("blur");
+    blur(x, y) = sum / taps;
+
+    Var xo, xi;
+    const int vec = t.natural_vector_size<uint16_t>();
+    in16.compute_at(blur, y).vectorize(x, vec);
+    blur.split(x, xo, xi, vec).vectorize(xi).parallel(y);
+
+    CountLoads checker(in16.name(), xo.name());
+    blur.add_custom_lowering_pass(&checker, []() {});
+    blur.compile_jit(t);
+    blur.realize(out, t);
+    return {benchmark([&]() { blur.realize(out, t); }), checker.loads};
+}
+
+int main(int argc, char **argv) {
+    Target target = get_jit_target_from_environment();
+    if (target.arch == Target::WebAssembly) {
+        printf("[SKIP] Performance tests are meaningless and/or misleading under WebAssembly interpreter.\n");
+        return 0;
+    }
+
+    const int W = 4096, H = 1024;
+    input = Buffer<uint16_t>(W, H);
+    input.for_each_value([](uint16_t &v) { v = rand() & 0xff; });
+
+    Buffer<uint16_t> reference(W, H), out(W, H);
+
+    for (int taps : {3, 5, 9, 17}) {
+        Result reload = run(taps, target.without_feature(Target::LoopCarry), reference);
+        Result carry = run(taps, target.with_feature(Target::LoopCarry), out);
+
+        for (int y = 0; y < H; y++) {
+            for (int x = 0; x < W; x++) {
+                if (out(x, y) != reference(x, y)) {
+                    printf("1x%d box filter: out(%d, %d) = %d instead of %d\n",
+                           taps, x, y, out(x, y), reference(x, y));
+                    return -1;
+                }
+            }
+        }
+
+        printf("1x%-2d box filter: reloading: %d loads, %f ms  carrying: %d loads, %f ms  speed-up: %.2fx\n",
+               taps, reload.loads, reload.time * 1e3, carry.loads, carry.time * 1e3, reload.time / carry.time);
+
+        if (carry.loads >= reload.loads) {
+            printf("Loop carry did not remove any of the %d loads per iteration.\n", reload.loads);
+            return -1;
+        }
+
+        // Timings are noisy on shared machines, so only fail on a
+        // large slowdown.
+        if (carry.time > 3 * reload.time) {
+            printf("Carrying vectors across loop iterations is much slower than reloading them.\n");
+            return -1;
+        }
+    }
+
+    input = Buffer<uint16_t>();
+
+    printf("Success!\n");
+    return 0;
+}
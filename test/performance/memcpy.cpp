@@ -49,6 +49,91 @@ int main(int argc, char **argv) {
         return -1;
     }
 
+    // Copies of cropped and strided buffers go through
+    // halide_buffer_copy, which fuses the dimensions it can and splits
+    // the rest across the thread pool.
+    {
+        ImageParam src(UInt(8), 3);
+        Func copy;
+        Var y, c;
+        copy(x, y, c) = src(x, y, c);
+        copy.copy_to_host();
+        copy.compile_jit();
+
+        Buffer<uint8_t> input(4096, 1024, 3);
+        input.for_each_element([&](int x, int y, int c) {
+            input(x, y, c) = (uint8_t)(x + 3 * y + 101 * c);
+        });
+        src.set(input);
+
+        // Check a copy against the input before the memcpy baselines
+        // overwrite it with the right answer.
+        auto check_copy = [&](const Buffer<uint8_t> &out, const char *name) {
+            out.for_each_element([&](int x, int y, int c) {
+                if (out(x, y, c) != input(x, y, c)) {
+                    printf("halide_buffer_copy %s: out(%d, %d, %d) = %d instead of %d\n",
+                           name, x, y, c, out(x, y, c), input(x, y, c));
+                    exit(-1);
+                }
+            });
+        };
+
+        // A crop in x: one memcpy per row
+        Buffer<uint8_t> cropped(3000, 1024, 3);
+        double t_crop = benchmark([&]() {
+            copy.realize(cropped);
+        });
+        check_copy(cropped, "of a crop");
+        double t_rows = benchmark([&]() {
+            for (int ci = 0; ci < 3; ci++) {
+                for (int yi = 0; yi < 1024; yi++) {
+                    memcpy(&cropped(0, yi, ci), &input(0, yi, ci), 3000);
+                }
+            }
+        });
+
+        // A crop in x and c, into an interleaved buffer: every
+        // element is copied individually.
+        Buffer<uint8_t> interleaved = Buffer<uint8_t>::make_interleaved(3000, 1024, 2);
+        double t_interleaved = benchmark([&]() {
+            copy.realize(interleaved);
+        });
+        check_copy(interleaved, "to interleaved");
+
+        const double cropped_bytes = (double)cropped.size_in_bytes();
+        const double interleaved_bytes = (double)interleaved.size_in_bytes();
+        printf("system memcpy of rows:      %.3e byte/s\n", cropped_bytes / t_rows);
+        printf("halide_buffer_copy of crop: %.3e byte/s\n", cropped_bytes / t_crop);
+        printf("halide_buffer_copy to interleaved: %.3e byte/s\n", interleaved_bytes / t_interleaved);
+
+        if (t_crop > t_rows * 3) {
+            printf("halide_buffer_copy of a crop is slower than it should be.\n");
+            return -1;
+        }
+
+        // A crop smaller than MIN_PARALLEL_COPY_BYTES stays on this
+        // thread, so it shouldn't pay for waking up the thread pool.
+        Buffer<uint8_t> small(200, 256, 3);
+        double t_small = benchmark([&]() {
+            copy.realize(small);
+        });
+        check_copy(small, "of a small crop");
+        double t_small_rows = benchmark([&]() {
+            for (int ci = 0; ci < 3; ci++) {
+                for (int yi = 0; yi < 256; yi++) {
+                    memcpy(&small(0, yi, ci), &input(0, yi, ci), 200);
+                }
+            }
+        });
+        printf("system memcpy of small rows:      %.3e byte/s\n", small.size_in_bytes() / t_small_rows);
+        printf("halide_buffer_copy of small crop: %.3e byte/s\n", small.size_in_bytes() / t_small);
+
+        if (t_small > t_small_rows * 3) {
+            printf("halide_buffer_copy of a small crop is slower than it should be.\n");
+            return -1;
+        }
+    }
+
     printf("Success!\n");
     return 0;
 }
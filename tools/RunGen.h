@@ -1,8 +1,10 @@
 #include "HalideBuffer.h"
 #include "HalideRuntime.h"
 #include "halide_benchmark.h"
-#include "halide_image_io.h"
+#include "halide_image_io_mapped.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstdio>
 #include <cstdlib>
 #include <iomanip>
@@ -13,6 +15,7 @@
 #include <set>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <utility>
 
 #include <vector>
@@ -480,7 +483,12 @@ inline Buffer<> load_input_from_file(const std::string &pathname,
                                      const halide_filter_argument_t &metadata) {
     Buffer<> b = Buffer<>(metadata.type, 0);
     info() << "Loading input " << metadata.name << " from " << pathname << " ...";
-    if (!Halide::Tools::load<Buffer<>, IOCheckFail>(pathname, &b)) {
+    // Formats with a raw planar payload can be mapped instead of read, which
+    // saves a copy, and lets concurrent processes share the pages. If that
+    // doesn't work (e.g. the payload is misaligned), load it normally.
+    if (Halide::Tools::load_mapped<Buffer<>, Halide::Tools::Internal::CheckReturn>(pathname, &b)) {
+        info() << "Mapped input " << metadata.name << " from " << pathname;
+    } else if (!Halide::Tools::load<Buffer<>, IOCheckFail>(pathname, &b)) {
         fail() << "Unable to load input: " << pathname;
     }
     if (b.dimensions() != metadata.dimensions) {
@@ -1284,6 +1292,7 @@ public:
         Halide::Tools::BenchmarkConfig config;
         config.min_time = benchmark_min_time;
         config.max_time = benchmark_min_time * 4;
+        config.name = md->name;
         auto result = Halide::Tools::benchmark(benchmark_inner, config);
 
         if (!parsable_output) {
@@ -1302,6 +1311,122 @@ public:
         }
     }
 
+    // Run N invocations of the filter at once, for each N given, to measure
+    // aggregate throughput and the latency distribution under contention
+    // (e.g. for the thread pool).
+    void run_for_throughput(const std::vector<int> &concurrency_levels, double min_time) {
+        for (int n : concurrency_levels) {
+            // Each invocation gets its own copy of every buffer, as
+            // independent requests would. The first one uses the original
+            // buffers, so that the outputs can still be saved.
+            std::vector<std::vector<Buffer<>>> copies(n);
+            std::vector<std::vector<Buffer<> *>> outputs(n);
+            std::vector<std::vector<void *>> argvs(n);
+            for (int i = 0; i < n; i++) {
+                argvs[i] = build_filter_argv();
+                copies[i].reserve(args.size());
+                for (auto &arg_pair : args) {
+                    auto &arg = arg_pair.second;
+                    if (arg.metadata->kind == halide_argument_kind_input_scalar) {
+                        continue;
+                    }
+                    Buffer<> *b = &arg.buffer_value;
+                    if (i > 0) {
+                        if (arg.metadata->kind == halide_argument_kind_output_buffer) {
+                            // The outputs may be dirty on the device from
+                            // earlier runs, and their contents don't matter,
+                            // so just make new ones of the same shape.
+                            std::vector<int> sizes, mins;
+                            for (int d = 0; d < arg.buffer_value.dimensions(); d++) {
+                                sizes.push_back(arg.buffer_value.dim(d).extent());
+                                mins.push_back(arg.buffer_value.dim(d).min());
+                            }
+                            copies[i].emplace_back(arg.buffer_value.type(), sizes);
+                            copies[i].back().set_min(mins);
+                        } else {
+                            arg.buffer_value.copy_to_host();
+                            copies[i].push_back(arg.buffer_value.copy());
+                        }
+                        b = &copies[i].back();
+                        argvs[i][arg.index] = b->raw_buffer();
+                    }
+                    if (arg.metadata->kind == halide_argument_kind_output_buffer) {
+                        outputs[i].push_back(b);
+                    }
+                }
+            }
+
+            info() << "Measuring throughput with " << n << " concurrent invocations...";
+
+            std::vector<std::vector<double>> latencies(n);
+            std::atomic<int> ready(0);
+            std::atomic<bool> go(false);
+            const auto run_once = [&](int i) {
+                // Ignore result since our halide_error() should catch everything.
+                (void)halide_argv_call(&argvs[i][0]);
+                for (Buffer<> *b : outputs[i]) {
+                    b->device_sync();
+                }
+            };
+            const auto worker = [&](int i) {
+                // Warm up (allocation caches, device contexts) before all
+                // the invocations start together.
+                run_once(i);
+                ready++;
+                while (!go) {
+                    std::this_thread::yield();
+                }
+                const auto start = Halide::Tools::benchmark_now();
+                do {
+                    const auto t0 = Halide::Tools::benchmark_now();
+                    run_once(i);
+                    latencies[i].push_back(Halide::Tools::benchmark_duration_seconds(t0, Halide::Tools::benchmark_now()));
+                } while (Halide::Tools::benchmark_duration_seconds(start, Halide::Tools::benchmark_now()) < min_time);
+            };
+
+            std::vector<std::thread> threads;
+            for (int i = 0; i < n; i++) {
+                threads.emplace_back(worker, i);
+            }
+            while (ready < n) {
+                std::this_thread::yield();
+            }
+            const auto start = Halide::Tools::benchmark_now();
+            go = true;
+            for (auto &t : threads) {
+                t.join();
+            }
+            const double wall_time = Halide::Tools::benchmark_duration_seconds(start, Halide::Tools::benchmark_now());
+
+            std::vector<double> all;
+            for (const auto &l : latencies) {
+                all.insert(all.end(), l.begin(), l.end());
+            }
+            std::sort(all.begin(), all.end());
+            const auto percentile = [&](double p) {
+                return all[std::min(all.size() - 1, (size_t)(p * all.size()))];
+            };
+            const double iters_per_sec = all.size() / wall_time;
+            const double p50 = percentile(0.5), p90 = percentile(0.9), p99 = percentile(0.99);
+
+            if (!parsable_output) {
+                out() << "Throughput for " << md->name << " with " << n << " concurrent invocations is "
+                      << iters_per_sec << " iters/sec (" << (megapixels_out() * iters_per_sec) << " mpix/sec) over "
+                      << all.size() << " iterations.\n"
+                      << "Latency is " << std::setprecision(4) << p50 * 1000 << " ms at p50, "
+                      << p90 * 1000 << " ms at p90, " << p99 * 1000 << " ms at p99.\n";
+            } else {
+                const std::string prefix = std::string(md->name) + "  CONCURRENCY_" + std::to_string(n) + "_";
+                out() << prefix << "ITERS_PER_SEC            " << iters_per_sec << "\n"
+                      << prefix << "THROUGHPUT_MPIX_PER_SEC  " << (megapixels_out() * iters_per_sec) << "\n"
+                      << prefix << "ITERATIONS               " << all.size() << "\n"
+                      << prefix << "P50_MSEC                 " << p50 * 1000 << "\n"
+                      << prefix << "P90_MSEC                 " << p90 * 1000 << "\n"
+                      << prefix << "P99_MSEC                 " << p99 * 1000 << "\n";
+            }
+        }
+    }
+
     struct Output {
         std::string name;
         Buffer<> actual;
@@ -139,6 +139,14 @@ Flags:
         Override the default minimum desired benchmarking time; ignored if
         --benchmarks is not also specified.
 
+    --concurrency=N or --concurrency=[N,N,...]:
+        Measure throughput with N invocations of the filter running at once,
+        each with its own copies of the input and output buffers, for each N
+        given; use a list of values to sweep over N and find where throughput
+        saturates. Reports aggregate throughput and the p50/p90/p99 latency
+        of single invocations. Each N runs for the time given by
+        --benchmark_min_time.
+
     --track_memory:
         Override Halide memory allocator to track high-water mark of memory
         allocation during run; note that this may slow down execution, so
@@ -375,6 +383,7 @@ int main(int argc, char **argv) {
     std::string user_specified_output_shape;
     std::set<std::string> seen_args;
     bool benchmark = false;
+    std::vector<int> concurrency;
     bool track_memory = false;
     bool describe = false;
     double benchmark_min_time = BenchmarkConfig().min_time;
@@ -437,6 +446,21 @@ int main(int argc, char **argv) {
             } else if (flag_name == "benchmarks") {
                 benchmarks_flag_value = flag_value;
                 benchmark = true;
+            } else if (flag_name == "concurrency") {
+                std::string levels = flag_value;
+                if (levels.size() >= 2 && levels.front() == '[' && levels.back() == ']') {
+                    levels = levels.substr(1, levels.size() - 2);
+                }
+                for (const std::string &level : split_string(levels, ",")) {
+                    int n = 0;
+                    if (!parse_scalar(level, &n) || n < 1) {
+                        fail() << "Invalid value for flag: " << flag_name;
+                    }
+                    concurrency.push_back(n);
+                }
+                if (concurrency.empty()) {
+                    fail() << "Invalid value for flag: " << flag_name;
+                }
             } else if (flag_name == "benchmark_min_time") {
                 if (!parse_scalar(flag_value, &benchmark_min_time)) {
                     fail() << "Invalid value for flag: " << flag_name;
@@ -482,10 +506,10 @@ int main(int argc, char **argv) {
     }
 
     // It's OK to omit output arguments when we are benchmarking or tracking memory.
-    bool ok_to_omit_outputs = (benchmark || track_memory);
+    bool ok_to_omit_outputs = (benchmark || !concurrency.empty() || track_memory);
 
-    if (benchmark && track_memory) {
-        warn() << "Using --track_memory with --benchmarks will produce inaccurate benchmark results.";
+    if ((benchmark || !concurrency.empty()) && track_memory) {
+        warn() << "Using --track_memory with --benchmarks or --concurrency will produce inaccurate benchmark results.";
     }
 
     // Check to be sure that all required arguments are specified.
@@ -520,7 +544,11 @@ int main(int argc, char **argv) {
             fail() << "The only valid value for --benchmarks is 'all'";
         }
         r.run_for_benchmark(benchmark_min_time);
-    } else {
+    }
+    if (!concurrency.empty()) {
+        r.run_for_throughput(concurrency, benchmark_min_time);
+    }
+    if (!benchmark && concurrency.empty()) {
         r.run_for_output();
     }
 
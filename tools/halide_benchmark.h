@@ -4,8 +4,16 @@
 #include <algorithm>
 #include <cassert>
 #include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
 #include <functional>
 #include <limits>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
 
 #if defined(__EMSCRIPTEN__)
 #include <emscripten.h>
@@ -57,6 +65,251 @@ inline double benchmark_duration_seconds(double start, double end) {
 
 #endif
 
+// Robust statistics over a set of benchmark samples, each of which is the
+// time in seconds for one iteration (averaged over iterations_per_sample
+// back-to-back runs).
+struct BenchmarkStats {
+    // Every sample taken after warmup, in the order taken.
+    std::vector<double> samples;
+    uint64_t iterations_per_sample{1};
+
+    double min{0};
+    double mean{0};
+    double median{0};
+    // Median absolute deviation from the median.
+    double mad{0};
+
+    // Bootstrap confidence interval for the median.
+    double confidence{0.95};
+    double median_low{0};
+    double median_high{0};
+
+    // Number of samples with a modified z-score (based on the median and
+    // MAD) above 3.5. They're kept in samples, but the median and MAD are
+    // insensitive to them.
+    int outliers{0};
+
+    // One JSON object, on one line, so that many benchmarks can be
+    // appended to the same file.
+    std::string to_json(const std::string &name) const {
+        std::string json = "{\"name\": \"";
+        for (char c : name) {
+            if (c == '"' || c == '\\') {
+                json += '\\';
+            }
+            json += c;
+        }
+        json += '"';
+        char buf[64];
+        const auto add = [&](const char *key, double value) {
+            snprintf(buf, sizeof(buf), "%.9g", value);
+            json += std::string(", \"") + key + "\": " + buf;
+        };
+        add("iterations_per_sample", (double)iterations_per_sample);
+        add("min", min);
+        add("mean", mean);
+        add("median", median);
+        add("mad", mad);
+        add("confidence", confidence);
+        add("median_low", median_low);
+        add("median_high", median_high);
+        add("outliers", outliers);
+        json += ", \"samples\": [";
+        for (size_t i = 0; i < samples.size(); i++) {
+            snprintf(buf, sizeof(buf), "%s%.9g", i ? ", " : "", samples[i]);
+            json += buf;
+        }
+        json += "]}";
+        return json;
+    }
+};
+
+namespace BenchmarkInternal {
+
+inline double median_of(std::vector<double> v) {
+    assert(!v.empty());
+    const size_t mid = v.size() / 2;
+    std::nth_element(v.begin(), v.begin() + mid, v.end());
+    double m = v[mid];
+    if (v.size() % 2 == 0) {
+        m = (m + *std::max_element(v.begin(), v.begin() + mid)) / 2;
+    }
+    return m;
+}
+
+// Bootstrap the distribution of some statistic of resampled data, and
+// return its (lo, hi) quantiles. A fixed seed keeps reports reproducible.
+template<typename F>
+std::pair<double, double> bootstrap_interval(F statistic, int resamples, double confidence) {
+    std::mt19937 rng(0);
+    std::vector<double> stats(std::max(resamples, 1));
+    for (double &s : stats) {
+        s = statistic(rng);
+    }
+    std::sort(stats.begin(), stats.end());
+    const double tail = (1 - confidence) / 2;
+    const size_t lo = (size_t)(tail * (stats.size() - 1) + 0.5);
+    const size_t hi = (size_t)((1 - tail) * (stats.size() - 1) + 0.5);
+    return {stats[lo], stats[hi]};
+}
+
+inline std::vector<double> resample(const std::vector<double> &v, std::mt19937 &rng) {
+    std::uniform_int_distribution<size_t> pick(0, v.size() - 1);
+    std::vector<double> r(v.size());
+    for (double &x : r) {
+        x = v[pick(rng)];
+    }
+    return r;
+}
+
+}  // namespace BenchmarkInternal
+
+inline BenchmarkStats compute_benchmark_stats(const std::vector<double> &samples,
+                                              uint64_t iterations_per_sample = 1,
+                                              double confidence = 0.95,
+                                              int bootstrap_resamples = 1000) {
+    BenchmarkStats s;
+    s.samples = samples;
+    s.iterations_per_sample = iterations_per_sample;
+    s.confidence = confidence;
+    if (samples.empty()) {
+        return s;
+    }
+    s.min = *std::min_element(samples.begin(), samples.end());
+    for (double x : samples) {
+        s.mean += x / samples.size();
+    }
+    s.median = BenchmarkInternal::median_of(samples);
+    std::vector<double> deviations;
+    for (double x : samples) {
+        deviations.push_back(std::abs(x - s.median));
+    }
+    s.mad = BenchmarkInternal::median_of(deviations);
+    for (double d : deviations) {
+        if (s.mad > 0 && 0.6745 * d / s.mad > 3.5) {
+            s.outliers++;
+        }
+    }
+    auto ci = BenchmarkInternal::bootstrap_interval(
+        [&](std::mt19937 &rng) { return BenchmarkInternal::median_of(BenchmarkInternal::resample(samples, rng)); },
+        bootstrap_resamples, confidence);
+    s.median_low = ci.first;
+    s.median_high = ci.second;
+    return s;
+}
+
+// If the environment variable HL_BENCHMARK_JSON names a file, append the
+// stats to it as one line of JSON. This is how benchmarks get into the
+// files compared by HalideBenchmarkCompare.
+inline void report_benchmark_stats(const std::string &name, const BenchmarkStats &stats) {
+    const char *path = getenv("HL_BENCHMARK_JSON");
+    if (!path || !*path) {
+        return;
+    }
+    FILE *f = fopen(path, "a");
+    if (!f) {
+        return;
+    }
+    fprintf(f, "%s\n", stats.to_json(name).c_str());
+    fclose(f);
+}
+
+namespace BenchmarkInternal {
+
+// The value of "key" in a line of JSON written by BenchmarkStats::to_json.
+// This isn't a general JSON parser.
+inline std::string json_value(const std::string &line, const std::string &key) {
+    size_t pos = line.find("\"" + key + "\": ");
+    if (pos == std::string::npos) {
+        return "";
+    }
+    pos += key.size() + 4;
+    size_t end;
+    if (line[pos] == '"') {
+        end = pos + 1;
+        while (end < line.size() && line[end] != '"') {
+            end += line[end] == '\\' ? 2 : 1;
+        }
+        end++;
+    } else if (line[pos] == '[') {
+        end = line.find(']', pos) + 1;
+    } else {
+        end = line.find_first_of(",}", pos);
+    }
+    return line.substr(pos, end - pos);
+}
+
+}  // namespace BenchmarkInternal
+
+// Read back the samples of each benchmark in a file written by
+// report_benchmark_stats. If a benchmark appears more than once (e.g.
+// from repeated runs), its samples are pooled. Returns false if the file
+// can't be opened.
+inline bool load_benchmark_samples(const std::string &filename,
+                                   std::map<std::string, std::vector<double>> *results) {
+    std::ifstream in(filename);
+    if (!in) {
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string name = BenchmarkInternal::json_value(line, "name");
+        std::string samples = BenchmarkInternal::json_value(line, "samples");
+        if (name.size() < 2 || samples.size() < 2) {
+            continue;
+        }
+        std::string unescaped;
+        for (size_t i = 1; i + 1 < name.size(); i++) {
+            if (name[i] == '\\') {
+                i++;
+            }
+            unescaped += name[i];
+        }
+        std::vector<double> &v = (*results)[unescaped];
+        const char *p = samples.c_str() + 1;
+        char *end;
+        for (double x = strtod(p, &end); end != p; x = strtod(p, &end)) {
+            v.push_back(x);
+            p = end;
+            while (*p == ',' || *p == ' ') {
+                p++;
+            }
+        }
+    }
+    return true;
+}
+
+namespace BenchmarkInternal {
+
+// Benchmarks that aren't given a name are called $HL_BENCHMARK_NAME (or
+// "benchmark") followed by the number of benchmarks reported before them
+// in this process, which is stable from run to run.
+inline std::string next_benchmark_name() {
+    static int count = 0;
+    const char *prefix = getenv("HL_BENCHMARK_NAME");
+    return std::string(prefix && *prefix ? prefix : "benchmark") + "/" + std::to_string(count++);
+}
+
+inline void report_benchmark_samples(const std::string &name, const std::vector<double> &samples, uint64_t iterations) {
+    // Skip the cost of the bootstrap unless someone is listening.
+    const char *path = getenv("HL_BENCHMARK_JSON");
+    if (path && *path && !samples.empty()) {
+        report_benchmark_stats(name.empty() ? next_benchmark_name() : name,
+                               compute_benchmark_stats(samples, iterations));
+    }
+}
+
+inline double benchmark_sample(uint64_t iterations, const std::function<void()> &op) {
+    auto start = benchmark_now();
+    for (uint64_t j = 0; j < iterations; j++) {
+        op();
+    }
+    auto end = benchmark_now();
+    return benchmark_duration_seconds(start, end) / iterations;
+}
+
+}  // namespace BenchmarkInternal
+
 // Benchmark the operation 'op'. The number of iterations refers to
 // how many times the operation is run for each time measurement, the
 // result is the minimum over a number of samples runs. The result is the
@@ -76,16 +329,13 @@ inline double benchmark_duration_seconds(double start, double end) {
 
 inline double benchmark(uint64_t samples, uint64_t iterations, const std::function<void()> &op) {
     double best = std::numeric_limits<double>::infinity();
+    std::vector<double> times;
     for (uint64_t i = 0; i < samples; i++) {
-        auto start = benchmark_now();
-        for (uint64_t j = 0; j < iterations; j++) {
-            op();
-        }
-        auto end = benchmark_now();
-        double elapsed_seconds = benchmark_duration_seconds(start, end);
-        best = std::min(best, elapsed_seconds);
+        times.push_back(BenchmarkInternal::benchmark_sample(iterations, op));
+        best = std::min(best, times.back());
     }
-    return best / iterations;
+    BenchmarkInternal::report_benchmark_samples("", times, iterations);
+    return best;
 }
 
 // Benchmark the operation 'op': run the operation until at least min_time
@@ -120,6 +370,9 @@ struct BenchmarkConfig {
     // this. Controls accuracy. The closer to zero this gets the more
     // reliable the answer, but the longer it may take to run.
     double accuracy{0.03};
+
+    // The name to report the samples under (see report_benchmark_stats).
+    std::string name;
 };
 
 struct BenchmarkResult {
@@ -161,12 +414,15 @@ inline BenchmarkResult benchmark(const std::function<void()> &op, const Benchmar
 
     double total_time = 0;
     uint64_t iters_per_sample = 1;
+    std::vector<double> samples;
     for (;;) {
         result.samples = 0;
         result.iterations = 0;
         total_time = 0;
+        samples.clear();
         for (int i = 0; i < kMinSamples; i++) {
-            times[i] = benchmark(1, iters_per_sample, op);
+            times[i] = BenchmarkInternal::benchmark_sample(iters_per_sample, op);
+            samples.push_back(times[i]);
             result.samples++;
             result.iterations += iters_per_sample;
             total_time += times[i] * iters_per_sample;
@@ -188,7 +444,8 @@ inline BenchmarkResult benchmark(const std::function<void()> &op, const Benchmar
     // to throttled-down CPU state.
     while ((times[0] * accuracy < times[kMinSamples - 1] || total_time < min_time) &&
            total_time < max_time) {
-        times[kMinSamples] = benchmark(1, iters_per_sample, op);
+        times[kMinSamples] = BenchmarkInternal::benchmark_sample(iters_per_sample, op);
+        samples.push_back(times[kMinSamples]);
         result.samples++;
         result.iterations += iters_per_sample;
         total_time += times[kMinSamples] * iters_per_sample;
@@ -197,9 +454,103 @@ inline BenchmarkResult benchmark(const std::function<void()> &op, const Benchmar
     result.wall_time = times[0];
     result.accuracy = (times[kMinSamples - 1] / times[0]) - 1.0;
 
+    BenchmarkInternal::report_benchmark_samples(config.name, samples, iters_per_sample);
+
     return result;
 }
 
+// Benchmark the operation 'op' for statistical comparison, rather than
+// for a best-case time: after some warmup iterations, take samples of
+// iterations_per_sample iterations each (chosen so that a sample takes
+// about sample_time) until there are at least min_samples and at least
+// min_time has elapsed, or until max_time or max_samples is reached.
+// The stats are also reported under config.name, if it's not empty.
+struct BenchmarkStatsConfig {
+    int warmup_iterations{1};
+    double sample_time{0.01};
+    int min_samples{10};
+    int max_samples{1000};
+    double min_time{0.1};
+    double max_time{1.0};
+    double confidence{0.95};
+    int bootstrap_resamples{1000};
+    std::string name;
+};
+
+inline BenchmarkStats benchmark_stats(const std::function<void()> &op, const BenchmarkStatsConfig &config = {}) {
+    for (int i = 0; i < config.warmup_iterations; i++) {
+        op();
+    }
+
+    // Find a number of iterations per sample that takes at least sample_time.
+    uint64_t iters_per_sample = 1;
+    double t = BenchmarkInternal::benchmark_sample(iters_per_sample, op);
+    while (t * iters_per_sample < config.sample_time && iters_per_sample < kBenchmarkMaxIterations) {
+        iters_per_sample = std::max(iters_per_sample * 2,
+                                    (uint64_t)(config.sample_time / std::max(t, 1e-9) + 0.5));
+        t = BenchmarkInternal::benchmark_sample(iters_per_sample, op);
+    }
+
+    std::vector<double> samples;
+    double total_time = 0;
+    while ((int)samples.size() < config.max_samples &&
+           (((int)samples.size() < config.min_samples || total_time < config.min_time) &&
+            total_time < config.max_time)) {
+        samples.push_back(BenchmarkInternal::benchmark_sample(iters_per_sample, op));
+        total_time += samples.back() * iters_per_sample;
+    }
+
+    BenchmarkStats stats = compute_benchmark_stats(samples, iters_per_sample,
+                                                   config.confidence, config.bootstrap_resamples);
+    if (!config.name.empty()) {
+        report_benchmark_stats(config.name, stats);
+    }
+    return stats;
+}
+
+// The ratio of the candidate's median time to the baseline's, with a
+// bootstrap confidence interval. The difference is significant if the
+// interval excludes 1.
+struct BenchmarkComparison {
+    double ratio{1};
+    double ratio_low{1};
+    double ratio_high{1};
+
+    bool significant() const {
+        return ratio_low > 1 || ratio_high < 1;
+    }
+
+    // A significant slowdown of more than the given fraction.
+    bool regression(double threshold = 0.0) const {
+        return ratio_low > 1 + threshold;
+    }
+
+    // A significant speed-up of more than the given fraction.
+    bool improvement(double threshold = 0.0) const {
+        return ratio_high < 1 - threshold;
+    }
+};
+
+inline BenchmarkComparison compare_benchmark_samples(const std::vector<double> &baseline,
+                                                     const std::vector<double> &candidate,
+                                                     double confidence = 0.95,
+                                                     int bootstrap_resamples = 1000) {
+    BenchmarkComparison c;
+    if (baseline.empty() || candidate.empty()) {
+        return c;
+    }
+    c.ratio = BenchmarkInternal::median_of(candidate) / BenchmarkInternal::median_of(baseline);
+    auto ci = BenchmarkInternal::bootstrap_interval(
+        [&](std::mt19937 &rng) {
+            return BenchmarkInternal::median_of(BenchmarkInternal::resample(candidate, rng)) /
+                   BenchmarkInternal::median_of(BenchmarkInternal::resample(baseline, rng));
+        },
+        bootstrap_resamples, confidence);
+    c.ratio_low = ci.first;
+    c.ratio_high = ci.second;
+    return c;
+}
+
 }  // namespace Tools
 }  // namespace Halide
 
@@ -5,13 +5,16 @@
 #define HALIDE_IMAGE_IO_H
 
 #include <algorithm>
+#include <cassert>
 #include <cctype>
 #include <cstdarg>
 #include <cstddef>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <functional>
 #include <map>
+#include <new>
 #include <set>
 #include <string>
 #include <vector>
@@ -1176,7 +1179,7 @@ inline const halide_type_t *tmp_code_to_halide_type() {
 template<typename ImageType>
 bool buffer_is_compact_planar(ImageType &im) {
     const halide_type_t im_type = im.type();
-    const size_t elem_size = (im_type.bits / 8);
+    const size_t elem_size = im_type.bytes();
     if (((const uint8_t *)im.begin() + (im.number_of_elements() * elem_size)) != (const uint8_t *)im.end()) {
         return false;
     }
@@ -1678,6 +1681,502 @@ bool save_mat(ImageType &im, const std::string &filename) {
     return true;
 }
 
+// Reads values out of a block of memory, such as a mapped file.
+struct MemoryReader {
+    const uint8_t *data;
+    size_t size, pos;
+
+    bool read_bytes(void *dst, size_t count) {
+        if (count > size - pos) {
+            return false;
+        }
+        memcpy(dst, data + pos, count);
+        pos += count;
+        return true;
+    }
+
+    template<typename T, size_t N>
+    bool read_array(T (&dst)[N]) {
+        return read_bytes(&dst[0], sizeof(T) * N);
+    }
+
+    template<typename T>
+    bool read_vector(std::vector<T> *v) {
+        return read_bytes(v->data(), v->size() * sizeof(T));
+    }
+
+    bool skip(size_t count) {
+        if (count > size - pos) {
+            return false;
+        }
+        pos += count;
+        return true;
+    }
+};
+
+// Find the element type, extents and payload offset of a .tmp file.
+template<CheckFunc check = CheckReturn>
+bool parse_tmp_header(MemoryReader &r, halide_type_t *type, std::vector<int> *extents) {
+    int32_t header[5];
+    if (!check(r.read_array(header), "Count not read .tmp header")) {
+        return false;
+    }
+    if (!check(header[0] > 0 && header[1] > 0 && header[2] > 0 && header[3] > 0 &&
+                   header[4] >= 0 && header[4] < kNumTmpCodes,
+               "Bad header on .tmp file")) {
+        return false;
+    }
+    *type = tmp_code_to_halide_type()[header[4]];
+    *extents = {header[0], header[1], header[2], header[3]};
+    return true;
+}
+
+// The same for a .mat file. This follows load_mat.
+template<CheckFunc check = CheckReturn>
+bool parse_mat_header(MemoryReader &r, halide_type_t *type, std::vector<int> *extents) {
+    uint32_t matrix_header[2], flags[4], shape_header[2], name_header[2], payload_header[2];
+    if (!check(r.skip(128) && r.read_array(matrix_header), "Could not read .mat header\n")) {
+        return false;
+    }
+    if (!check(matrix_header[0] == miMATRIX, "Could not parse this .mat file: bad matrix header\n")) {
+        return false;
+    }
+    if (!check(r.read_array(flags) && r.read_array(shape_header), "Could not read .mat header\n")) {
+        return false;
+    }
+    if (!check(flags[0] == miUINT32 && flags[1] == 8, "Could not parse this .mat file: bad flags\n") ||
+        !check(shape_header[0] == miINT32, "Could not parse this .mat file: bad shape header\n")) {
+        return false;
+    }
+    int dims = shape_header[1] / 4;
+    extents->resize(dims);
+    if (!check(r.read_vector(extents) && r.skip((dims & 1) ? 4 : 0) && r.read_array(name_header),
+               "Could not read .mat header\n")) {
+        return false;
+    }
+    if (!(name_header[0] >> 16)) {
+        // The name isn't packed into the header, so skip over it
+        if (!check(name_header[0] == miINT8, "Could not parse this .mat file: bad name header\n") ||
+            !check(r.skip((name_header[1] + 7) / 8 * 8), "Could not read .mat header\n")) {
+            return false;
+        }
+    }
+    if (!check(r.read_array(payload_header), "Could not read .mat header\n")) {
+        return false;
+    }
+    switch (payload_header[0]) {
+    case miINT8:
+        *type = halide_type_of<int8_t>();
+        break;
+    case miINT16:
+        *type = halide_type_of<int16_t>();
+        break;
+    case miINT32:
+        *type = halide_type_of<int32_t>();
+        break;
+    case miINT64:
+        *type = halide_type_of<int64_t>();
+        break;
+    case miUINT8:
+        *type = halide_type_of<uint8_t>();
+        break;
+    case miUINT16:
+        *type = halide_type_of<uint16_t>();
+        break;
+    case miUINT32:
+        *type = halide_type_of<uint32_t>();
+        break;
+    case miUINT64:
+        *type = halide_type_of<uint64_t>();
+        break;
+    case miSINGLE:
+        *type = halide_type_of<float>();
+        break;
+    case miDOUBLE:
+        *type = halide_type_of<double>();
+        break;
+    default:
+        return check(false, "Could not parse this .mat file: unsupported payload type\n");
+    }
+    return true;
+}
+
+// ".npy" is the numpy array format documented here:
+// https://numpy.org/doc/stable/reference/generated/numpy.lib.format.html
+//
+// The extents are returned in Halide order, innermost first, which is
+// the reverse of the numpy shape for the usual C-ordered arrays. If
+// byte_swapped is null, a payload in the other byte order from this
+// machine is an error; otherwise it's set to whether the payload needs
+// swapping.
+inline bool is_little_endian_host() {
+    const uint16_t one = 1;
+    return *(const uint8_t *)&one == 1;
+}
+
+template<CheckFunc check = CheckReturn>
+bool parse_npy_header(MemoryReader &r, halide_type_t *type, std::vector<int> *extents,
+                      bool *byte_swapped = nullptr) {
+    char magic[6];
+    uint8_t version[2];
+    if (!check(r.read_array(magic) && r.read_array(version), "Could not read .npy header\n") ||
+        !check(memcmp(magic, "\x93NUMPY", 6) == 0, "Bad magic number on .npy file\n")) {
+        return false;
+    }
+    uint32_t header_len = 0;
+    if (version[0] == 1) {
+        uint8_t len[2];
+        if (!check(r.read_array(len), "Could not read .npy header\n")) {
+            return false;
+        }
+        header_len = len[0] | (len[1] << 8);
+    } else {
+        uint8_t len[4];
+        if (!check(r.read_array(len), "Could not read .npy header\n")) {
+            return false;
+        }
+        header_len = len[0] | (len[1] << 8) | (len[2] << 16) | ((uint32_t)len[3] << 24);
+    }
+    std::string header(header_len, ' ');
+    if (!check(r.read_bytes(&header[0], header_len), "Could not read .npy header\n")) {
+        return false;
+    }
+
+    // The header is the repr of a python dict with three keys
+    auto value_of = [&](const std::string &key) -> std::string {
+        size_t pos = header.find("'" + key + "'");
+        if (pos == std::string::npos) {
+            return "";
+        }
+        pos = header.find(':', pos);
+        if (pos == std::string::npos) {
+            return "";
+        }
+        pos = header.find_first_not_of(' ', pos + 1);
+        if (pos == std::string::npos) {
+            return "";
+        }
+        char close = header[pos] == '(' ? ')' : header[pos] == '\'' ? '\'' : ',';
+        size_t end = header.find(close, pos + 1);
+        if (end == std::string::npos) {
+            return "";
+        }
+        return header.substr(pos, end + 1 - pos);
+    };
+    const std::string descr = value_of("descr");
+    const std::string fortran_order = value_of("fortran_order");
+    const std::string shape = value_of("shape");
+    if (!check(descr.size() >= 5 && !shape.empty() && !fortran_order.empty(),
+               "Could not parse this .npy file: bad header\n")) {
+        return false;
+    }
+
+    // descr is e.g. '<f4': the byte order, the kind, and the size in bytes
+    const char order = descr[1], kind = descr[2];
+    const int bytes = atoi(descr.c_str() + 3);
+    const bool swapped = bytes > 1 && (order == '<' || order == '>') &&
+                         (order == '<') != is_little_endian_host();
+    if (byte_swapped) {
+        *byte_swapped = swapped;
+    } else if (!check(!swapped, "Could not parse this .npy file: byte order does not match this machine\n")) {
+        return false;
+    }
+    if (kind == 'b' && bytes == 1) {
+        *type = halide_type_of<bool>();
+    } else if (kind == 'i' && (bytes == 1 || bytes == 2 || bytes == 4 || bytes == 8)) {
+        *type = halide_type_t(halide_type_int, bytes * 8);
+    } else if (kind == 'u' && (bytes == 1 || bytes == 2 || bytes == 4 || bytes == 8)) {
+        *type = halide_type_t(halide_type_uint, bytes * 8);
+    } else if (kind == 'f' && (bytes == 2 || bytes == 4 || bytes == 8)) {
+        *type = halide_type_t(halide_type_float, bytes * 8);
+    } else {
+        return check(false, "Could not parse this .npy file: unsupported dtype\n");
+    }
+
+    extents->clear();
+    for (size_t pos = 1; pos < shape.size();) {
+        char *end = nullptr;
+        long long extent = strtoll(shape.c_str() + pos, &end, 10);
+        if (end == shape.c_str() + pos) {
+            break;
+        }
+        if (!check(extent >= 0 && extent <= 0x7fffffff, "Could not parse this .npy file: bad shape\n")) {
+            return false;
+        }
+        extents->push_back((int)extent);
+        pos = shape.find(',', end - shape.c_str());
+        if (pos == std::string::npos) {
+            break;
+        }
+        pos++;
+    }
+    if (fortran_order.find("True") == std::string::npos) {
+        std::reverse(extents->begin(), extents->end());
+    }
+    return true;
+}
+
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool load_npy(const std::string &filename, ImageType *im) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    FileOpener f(filename, "rb");
+    if (!check(f.f != nullptr, "File could not be opened for reading")) {
+        return false;
+    }
+
+    // Read the magic number, version, and header length, and then the
+    // rest of the header, so it can be parsed in one piece.
+    std::vector<uint8_t> header(10);
+    if (!check(f.read_vector(&header), "Could not read .npy header\n")) {
+        return false;
+    }
+    size_t header_len = header[8] | (header[9] << 8);
+    if (header[6] >= 2) {
+        header.resize(12);
+        if (!check(f.read_bytes(&header[10], 2), "Could not read .npy header\n")) {
+            return false;
+        }
+        header_len |= (header[10] << 16) | ((size_t)header[11] << 24);
+    }
+    const size_t prefix_len = header.size();
+    header.resize(prefix_len + header_len);
+    if (!check(f.read_bytes(header.data() + prefix_len, header_len), "Could not read .npy header\n")) {
+        return false;
+    }
+
+    MemoryReader r = {header.data(), header.size(), 0};
+    halide_type_t im_type;
+    std::vector<int> im_dimensions;
+    bool byte_swapped = false;
+    if (!parse_npy_header<check>(r, &im_type, &im_dimensions, &byte_swapped)) {
+        return false;
+    }
+    *im = ImageType(im_type, im_dimensions);
+
+    // This should never fail unless the default Buffer<> constructor behavior changes.
+    if (!check(buffer_is_compact_planar(*im), "load_npy() requires compact planar images")) {
+        return false;
+    }
+
+    if (!check(f.read_bytes(im->begin(), im->size_in_bytes()), "Could not read .npy payload")) {
+        return false;
+    }
+
+    if (byte_swapped) {
+        const size_t elem_size = im_type.bytes();
+        uint8_t *p = (uint8_t *)im->begin();
+        for (size_t i = 0; i < im->number_of_elements(); i++, p += elem_size) {
+            std::reverse(p, p + elem_size);
+        }
+    }
+
+    im->set_host_dirty();
+    return true;
+}
+
+inline const std::set<FormatInfo> &query_npy() {
+    // .npy files can have any number of dimensions, including zero. Our
+    // support arbitrarily stops at 16 dimensions.
+    static std::set<FormatInfo> info = []() {
+        std::set<FormatInfo> s;
+        for (int i = 0; i < 16; i++) {
+            s.insert({halide_type_t(halide_type_float, 16), i});
+            s.insert({halide_type_t(halide_type_float, 32), i});
+            s.insert({halide_type_t(halide_type_float, 64), i});
+            s.insert({halide_type_t(halide_type_uint, 1), i});
+            s.insert({halide_type_t(halide_type_uint, 8), i});
+            s.insert({halide_type_t(halide_type_int, 8), i});
+            s.insert({halide_type_t(halide_type_uint, 16), i});
+            s.insert({halide_type_t(halide_type_int, 16), i});
+            s.insert({halide_type_t(halide_type_uint, 32), i});
+            s.insert({halide_type_t(halide_type_int, 32), i});
+            s.insert({halide_type_t(halide_type_uint, 64), i});
+            s.insert({halide_type_t(halide_type_int, 64), i});
+        }
+        return s;
+    }();
+    return info;
+}
+
+// The header of a C-ordered .npy file holding an array of the given
+// type and Halide extents (so the numpy shape is their reverse).
+inline std::vector<uint8_t> make_npy_header(halide_type_t type, const std::vector<int> &extents) {
+    std::string descr;
+    if (type == halide_type_t(halide_type_uint, 1)) {
+        descr = "|b1";
+    } else if (type.bytes() == 1) {
+        descr = type.code == halide_type_int ? "|i1" : "|u1";
+    } else {
+        descr = is_little_endian_host() ? "<" : ">";
+        descr += type.code == halide_type_int  ? "i" :
+                 type.code == halide_type_uint ? "u" :
+                                                 "f";
+        descr += std::to_string(type.bytes());
+    }
+    std::string shape = "(";
+    for (int i = (int)extents.size() - 1; i >= 0; i--) {
+        shape += std::to_string(extents[i]);
+        shape += (extents.size() == 1) ? "," : (i > 0 ? ", " : "");
+    }
+    shape += ")";
+    std::string dict = "{'descr': '" + descr + "', 'fortran_order': False, 'shape': " + shape + ", }";
+
+    // The whole header is padded with spaces to a multiple of 64 bytes,
+    // and ends in a newline. Version 1 has a 16-bit header length, which
+    // is enough unless there are very many dimensions.
+    const uint8_t version = (dict.size() + 10 + 64 > 0xffff) ? 2 : 1;
+    const size_t prefix_len = version == 1 ? 10 : 12;
+    const size_t total_len = (prefix_len + dict.size() + 1 + 63) / 64 * 64;
+    dict.resize(total_len - prefix_len - 1, ' ');
+    dict += '\n';
+
+    std::vector<uint8_t> header = {0x93, 'N', 'U', 'M', 'P', 'Y', version, 0};
+    for (size_t i = 0; i < prefix_len - 8; i++) {
+        header.push_back((uint8_t)(dict.size() >> (8 * i)));
+    }
+    header.insert(header.end(), dict.begin(), dict.end());
+    return header;
+}
+
+// The array is written in C order, so the numpy shape is the reverse of
+// the Halide extents, and the payload is the Buffer's planar layout.
+template<typename ImageType, CheckFunc check = CheckReturn>
+bool save_npy(ImageType &im, const std::string &filename) {
+    static_assert(!ImageType::has_static_halide_type, "");
+
+    im.copy_to_host();
+
+    const halide_type_t im_type = im.type();
+    if (!check(query_npy().count({im_type, 0}) > 0, "Unsupported type for .npy file")) {
+        return false;
+    }
+
+    std::vector<int> extents(im.dimensions());
+    for (int i = 0; i < im.dimensions(); i++) {
+        extents[i] = im.dim(i).extent();
+    }
+    const std::vector<uint8_t> header = make_npy_header(im_type, extents);
+
+    FileOpener f(filename, "wb");
+    if (!check(f.f != nullptr, "File could not be opened for writing")) {
+        return false;
+    }
+    if (!check(f.write_vector(header), "Could not write .npy header")) {
+        return false;
+    }
+
+    if (!write_planar_payload<ImageType, check>(im, f)) {
+        return false;
+    }
+
+    return true;
+}
+
+// Where the planar payload of a .tmp, .mat or .npy file is, and what it holds.
+struct RawImageLayout {
+    halide_type_t type;
+    std::vector<int> extents;
+    uint64_t payload_offset = 0;
+    bool byte_swapped = false;
+};
+
+inline bool seek_to(FILE *f, uint64_t offset) {
+#ifdef _WIN32
+    return _fseeki64(f, (__int64)offset, SEEK_SET) == 0;
+#else
+    return fseeko(f, (off_t)offset, SEEK_SET) == 0;
+#endif
+}
+
+template<CheckFunc check = CheckReturn>
+bool read_raw_layout(FileOpener &f, const std::string &ext, RawImageLayout *layout) {
+    // The headers are all small, so parse them out of the start of the file.
+    std::vector<uint8_t> prefix(65536);
+    prefix.resize(fread(prefix.data(), 1, prefix.size(), f.f));
+    MemoryReader r = {prefix.data(), prefix.size(), 0};
+    bool ok = (ext == "tmp" ? parse_tmp_header<check>(r, &layout->type, &layout->extents) :
+               ext == "mat" ? parse_mat_header<check>(r, &layout->type, &layout->extents) :
+               ext == "npy" ? parse_npy_header<check>(r, &layout->type, &layout->extents, &layout->byte_swapped) :
+                              check(false, "Only .tmp, .mat and .npy files can be read in tiles"));
+    layout->payload_offset = r.pos;
+    return ok;
+}
+
+// Copy the region of a raw payload covered by a buffer between the file
+// and the buffer, one row at a time. Dimensions the buffer doesn't have
+// are at coordinate zero.
+template<CheckFunc check = CheckReturn>
+bool transfer_region(FILE *f, const RawImageLayout &layout, const halide_buffer_t *buf, bool to_file) {
+    const halide_type_t t = buf->type;
+    if (!check(t.code == layout.type.code && t.bits == layout.type.bits && t.lanes == layout.type.lanes,
+               "Tile type does not match the image type")) {
+        return false;
+    }
+    const int dims = buf->dimensions;
+    for (int d = 0; d < dims; d++) {
+        const halide_dimension_t &dim = buf->dim[d];
+        const int extent = d < (int)layout.extents.size() ? layout.extents[d] : 1;
+        if (!check(dim.min >= 0 && dim.min + dim.extent <= extent, "Tile is outside the image")) {
+            return false;
+        }
+    }
+
+    const size_t elem_size = t.bytes();
+    std::vector<uint64_t> file_stride(dims);
+    uint64_t stride = 1;
+    for (int d = 0; d < dims; d++) {
+        file_stride[d] = stride;
+        stride *= d < (int)layout.extents.size() ? layout.extents[d] : 1;
+    }
+
+    const int row_len = dims > 0 ? buf->dim[0].extent : 1;
+    const int64_t row_stride = dims > 0 ? buf->dim[0].stride : 1;
+    std::vector<uint8_t> row(row_len * elem_size);
+    std::vector<int> pos(dims, 0);
+    while (true) {
+        uint64_t file_offset = 0;
+        int64_t buf_offset = 0;
+        for (int d = 0; d < dims; d++) {
+            file_offset += (buf->dim[d].min + pos[d]) * file_stride[d];
+            buf_offset += (int64_t)pos[d] * buf->dim[d].stride;
+        }
+        uint8_t *src = buf->host + buf_offset * elem_size;
+        if (!seek_to(f, layout.payload_offset + file_offset * elem_size)) {
+            return check(false, "Could not seek in image file");
+        }
+        if (to_file) {
+            for (int i = 0; i < row_len; i++) {
+                memcpy(&row[i * elem_size], src + i * row_stride * elem_size, elem_size);
+            }
+            if (!check(fwrite(row.data(), 1, row.size(), f) == row.size(), "Could not write tile")) {
+                return false;
+            }
+        } else {
+            if (!check(fread(row.data(), 1, row.size(), f) == row.size(), "Could not read tile")) {
+                return false;
+            }
+            for (int i = 0; i < row_len; i++) {
+                uint8_t *elem = &row[i * elem_size];
+                if (layout.byte_swapped) {
+                    std::reverse(elem, elem + elem_size);
+                }
+                memcpy(src + i * row_stride * elem_size, elem, elem_size);
+            }
+        }
+
+        // Move to the next row
+        int d = 1;
+        while (d < dims && ++pos[d] == buf->dim[d].extent) {
+            pos[d++] = 0;
+        }
+        if (d >= dims) {
+            break;
+        }
+    }
+    return true;
+}
+
 template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
 bool load_tiff(const std::string &filename, ImageType *im) {
     static_assert(!ImageType::has_static_halide_type, "");
@@ -1987,6 +2486,7 @@ bool find_imageio(const std::string &filename, ImageIO<ImageType, check> *result
         {"tmp", {load_tmp<ImageType, check>, save_tmp<ConstImageType, check>, query_tmp}},
         {"mat", {load_mat<ImageType, check>, save_mat<ConstImageType, check>, query_mat}},
         {"tiff", {load_tiff<ImageType, check>, save_tiff<ConstImageType, check>, query_tiff}},
+        {"npy", {load_npy<ImageType, check>, save_npy<ConstImageType, check>, query_npy}},
     };
     std::string ext = Internal::get_lowercase_extension(filename);
     auto it = m.find(ext);
@@ -2298,6 +2798,192 @@ private:
     const std::string filename;
 };
 
+// Reads regions of an image file on demand, so that images larger than
+// memory can be processed a tile at a time. Only formats with a raw
+// planar payload (.tmp, .mat and .npy) are supported.
+template<Internal::CheckFunc check = Internal::CheckReturn>
+class TiledImageReader {
+public:
+    TiledImageReader(const std::string &filename)
+        : f(filename, "rb") {
+        ok = check(f.f != nullptr, "File could not be opened for reading") &&
+             Internal::read_raw_layout<check>(f, Internal::get_lowercase_extension(filename), &layout);
+    }
+
+    // False if the file couldn't be opened or parsed.
+    bool is_open() const {
+        return ok;
+    }
+
+    halide_type_t type() const {
+        return layout.type;
+    }
+
+    const std::vector<int> &extents() const {
+        return layout.extents;
+    }
+
+    // Fill an allocated Image with the region of the file it covers. Its
+    // type must match the file's.
+    template<typename ImageType>
+    bool read(ImageType &tile) {
+        return check(ok, "Image file is not open") &&
+               Internal::transfer_region<check>(f.f, layout, tile.raw_buffer(), false);
+    }
+
+private:
+    Internal::FileOpener f;
+    Internal::RawImageLayout layout;
+    bool ok;
+};
+
+// Creates an image file of the given type and extents, and then writes
+// regions of it on demand. Only .tmp and .npy files are supported.
+template<Internal::CheckFunc check = Internal::CheckReturn>
+class TiledImageWriter {
+public:
+    TiledImageWriter(const std::string &filename, halide_type_t type, const std::vector<int> &extents)
+        : f(filename, "w+b") {
+        layout.type = type;
+        layout.extents = extents;
+        ok = check(f.f != nullptr, "File could not be opened for writing") && write_header(filename);
+    }
+
+    // False if the file couldn't be created.
+    bool is_open() const {
+        return ok;
+    }
+
+    halide_type_t type() const {
+        return layout.type;
+    }
+
+    const std::vector<int> &extents() const {
+        return layout.extents;
+    }
+
+    // Write the region of the file covered by an Image. Its type must
+    // match the file's.
+    template<typename ImageType>
+    bool write(ImageType &tile) {
+        tile.copy_to_host();
+        return check(ok, "Image file is not open") &&
+               Internal::transfer_region<check>(f.f, layout, tile.raw_buffer(), true);
+    }
+
+private:
+    bool write_header(const std::string &filename) {
+        const std::string ext = Internal::get_lowercase_extension(filename);
+        std::vector<uint8_t> header;
+        if (ext == "npy") {
+            if (!check(Internal::query_npy().count({layout.type, 0}) > 0, "Unsupported type for .npy file")) {
+                return false;
+            }
+            header = Internal::make_npy_header(layout.type, layout.extents);
+        } else if (ext == "tmp") {
+            // Dimensions past the caller's are written as 1 in the
+            // header only; the layout keeps the caller's extents.
+            int32_t tmp_header[5] = {1, 1, 1, 1, -1};
+            if (!check(layout.extents.size() <= 4, ".tmp files have at most 4 dimensions")) {
+                return false;
+            }
+            for (size_t i = 0; i < layout.extents.size(); i++) {
+                tmp_header[i] = layout.extents[i];
+            }
+            for (int i = 0; i < Internal::kNumTmpCodes; i++) {
+                if (layout.type == Internal::tmp_code_to_halide_type()[i]) {
+                    tmp_header[4] = i;
+                }
+            }
+            if (!check(tmp_header[4] >= 0, "Unsupported type for .tmp file")) {
+                return false;
+            }
+            header.resize(sizeof(tmp_header));
+            memcpy(header.data(), tmp_header, sizeof(tmp_header));
+        } else {
+            return check(false, "Only .tmp and .npy files can be written in tiles");
+        }
+        layout.payload_offset = header.size();
+
+        // Extend the file to its full size up front by writing its last
+        // byte, so tiles can be written in any order.
+        uint64_t payload_size = layout.type.bytes();
+        for (int e : layout.extents) {
+            payload_size *= e;
+        }
+        const uint8_t zero = 0;
+        return check(f.write_vector(header), "Could not write image header") &&
+               (payload_size == 0 ||
+                check(Internal::seek_to(f.f, layout.payload_offset + payload_size - 1) &&
+                          f.write_bytes(&zero, 1),
+                      "Could not extend image file"));
+    }
+
+    Internal::FileOpener f;
+    Internal::RawImageLayout layout;
+    bool ok;
+};
+
+// Realize a single-output Pipeline over an image too large to hold in
+// memory, one tile at a time. For each output tile, the region of the
+// input required is found with Pipeline::infer_input_bounds, read from
+// the input file, and bound to the ImageParam, so peak memory use is
+// bounded by the tile size. The pipeline must not access the input
+// outside the image (use a BoundaryConditions function with explicit
+// bounds). As with the ShiftInwards tail strategy, tiles at the edges
+// are shifted inwards rather than shrunk, so every tile has the same
+// size unless the image is smaller than a tile. Dimensions of the output
+// beyond those in tile_extents, such as channels, aren't split.
+template<typename PipelineType, typename ImageParamType, Internal::CheckFunc check = Internal::CheckReturn>
+bool realize_tiled(PipelineType &pipeline, ImageParamType &input,
+                   TiledImageReader<check> &reader, TiledImageWriter<check> &writer,
+                   const std::vector<int> &tile_extents) {
+    using BufferType = decltype(input.get());
+    const std::vector<int> &extents = writer.extents();
+    const int dims = (int)tile_extents.size();
+    if (!check(dims <= (int)extents.size(), "Too many tile dimensions for the output image")) {
+        return false;
+    }
+    // Dimensions without a tile extent (e.g. channels) are realized
+    // whole in every tile.
+    std::vector<int> sizes(extents), mins(extents.size(), 0);
+    for (int d = 0; d < dims; d++) {
+        sizes[d] = std::min(tile_extents[d], extents[d]);
+    }
+
+    while (true) {
+        BufferType out_tile(writer.type(), sizes);
+        out_tile.set_min(mins);
+
+        input.reset();
+        pipeline.infer_input_bounds(out_tile);
+        BufferType in_tile = input.get();
+        if (!reader.read(in_tile)) {
+            return false;
+        }
+        in_tile.set_host_dirty();
+        pipeline.realize(out_tile);
+        if (!writer.write(out_tile)) {
+            return false;
+        }
+
+        // Move to the next tile
+        int d = 0;
+        for (; d < dims; d++) {
+            if (mins[d] + sizes[d] < extents[d]) {
+                mins[d] = std::min(mins[d] + sizes[d], extents[d] - sizes[d]);
+                break;
+            }
+            mins[d] = 0;
+        }
+        if (d == dims) {
+            break;
+        }
+    }
+    input.reset();
+    return true;
+}
+
 // Like load_image, but quietly convert the loaded image to the type of the LHS
 // if necessary, discarding information if necessary.
 class load_and_convert_image {
@@ -0,0 +1,191 @@
+// This header adds load_mapped() and load_mapped_image() to
+// halide_image_io.h. They're kept separate because mapping a file needs
+// platform headers (<windows.h>, <sys/mman.h>, ...) that most users of
+// halide_image_io.h shouldn't have to include.
+
+#ifndef HALIDE_IMAGE_IO_MAPPED_H
+#define HALIDE_IMAGE_IO_MAPPED_H
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "HalideBuffer.h"
+#include "halide_image_io.h"
+
+namespace Halide {
+namespace Tools {
+
+namespace Internal {
+
+// A file mapped copy-on-write into memory, owned by the Buffers that
+// refer to it. The header must come first: when the last Buffer goes
+// away, it's passed to release(), which unmaps the file.
+struct MappedFile {
+    Halide::Runtime::AllocationHeader header;
+    void *data;
+    size_t size;
+
+    static void release(void *p) {
+        MappedFile *m = (MappedFile *)p;
+#ifdef _WIN32
+        UnmapViewOfFile(m->data);
+#else
+        munmap(m->data, m->size);
+#endif
+        free(m);
+    }
+
+    // Map a whole file, or return nullptr.
+    static MappedFile *open(const std::string &filename) {
+        void *data = nullptr;
+        size_t size = 0;
+#ifdef _WIN32
+        HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            return nullptr;
+        }
+        LARGE_INTEGER file_size;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &file_size) && file_size.QuadPart > 0) {
+            size = (size_t)file_size.QuadPart;
+            mapping = CreateFileMappingA(file, nullptr, PAGE_WRITECOPY, 0, 0, nullptr);
+        }
+        if (mapping) {
+            data = MapViewOfFile(mapping, FILE_MAP_COPY, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+        if (!data) {
+            return nullptr;
+        }
+#else
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return nullptr;
+        }
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0) {
+            size = (size_t)st.st_size;
+            // Private, so writes to the Buffer don't reach the file,
+            // but the pages are shared with the page cache until then.
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        }
+        close(fd);
+        if (data == nullptr || data == MAP_FAILED) {
+            return nullptr;
+        }
+#endif
+        MappedFile *m = (MappedFile *)malloc(sizeof(MappedFile));
+        new (&m->header) Halide::Runtime::AllocationHeader(release);
+        m->data = data;
+        m->size = size;
+        return m;
+    }
+};
+
+// Map a .tmp, .mat or .npy file and wrap its payload in a dense planar
+// Buffer, without copying it.
+template<CheckFunc check = CheckReturn>
+bool load_mapped_buffer(const std::string &filename, Halide::Runtime::Buffer<> *buf) {
+    const std::string ext = get_lowercase_extension(filename);
+    if (!check(ext == "tmp" || ext == "mat" || ext == "npy",
+               "Only .tmp, .mat and .npy files can be mapped")) {
+        return false;
+    }
+    MappedFile *m = MappedFile::open(filename);
+    if (!check(m != nullptr, "File could not be mapped for reading")) {
+        return false;
+    }
+
+    MemoryReader r = {(const uint8_t *)m->data, m->size, 0};
+    halide_type_t type;
+    std::vector<int> extents;
+    bool ok = (ext == "tmp" ? parse_tmp_header<check>(r, &type, &extents) :
+               ext == "mat" ? parse_mat_header<check>(r, &type, &extents) :
+                              parse_npy_header<check>(r, &type, &extents));
+
+    std::vector<halide_dimension_t> shape(extents.size());
+    uint64_t elems = 1;
+    for (size_t i = 0; i < extents.size(); i++) {
+        shape[i] = halide_dimension_t(0, extents[i], (int32_t)elems);
+        elems *= extents[i];
+    }
+    const size_t elem_size = type.bytes();
+    ok = ok &&
+         check(elems * elem_size <= m->size - r.pos, "File is too small for its payload") &&
+         check(elems <= 0x7fffffff, "Payload is too large to map into a Buffer") &&
+         check((uintptr_t)(r.data + r.pos) % elem_size == 0,
+               "Payload is not aligned for its type, so it can't be mapped. Load it instead.");
+    if (!ok) {
+        MappedFile::release(m);
+        return false;
+    }
+
+    // The Buffer takes over the header's reference.
+    *buf = Halide::Runtime::Buffer<>(type, (uint8_t *)m->data + r.pos, (int)shape.size(), shape.data(), &m->header);
+    return true;
+}
+
+}  // namespace Internal
+
+// Map a .tmp, .mat or .npy file into memory and wrap its payload in an
+// Image, without copying or decoding it. The mapping is copy-on-write:
+// the pages are shared with other processes mapping the same file until
+// they're written to, and writes never reach the file. The file is
+// unmapped when the last Image referring to it is destroyed.
+// If output Image has a static type, and the mapped image has a different
+// type, fail. Returns false upon failure.
+template<typename ImageType, Internal::CheckFunc check = Internal::CheckReturn>
+bool load_mapped(const std::string &filename, ImageType *im) {
+    using DynamicImageType = typename Internal::ImageTypeWithElemType<ImageType, void>::type;
+    Halide::Runtime::Buffer<> buf;
+    if (!Internal::load_mapped_buffer<check>(filename, &buf)) {
+        return false;
+    }
+    DynamicImageType im_d(std::move(buf));
+    if (ImageType::has_static_halide_type) {
+        const halide_type_t expected_type = ImageType::static_halide_type();
+        if (!check(im_d.type() == expected_type, "Image mapped did not match the expected type")) {
+            return false;
+        }
+    }
+    *im = im_d.template as<typename ImageType::ElemType>();
+    im->set_host_dirty();
+    return true;
+}
+
+// Like load_image, but maps the file with load_mapped instead of reading it.
+class load_mapped_image {
+public:
+    load_mapped_image(const std::string &f)
+        : filename(f) {
+    }
+
+    template<typename ImageType>
+    operator ImageType() {
+        using DynamicImageType = typename Internal::ImageTypeWithElemType<ImageType, void>::type;
+        DynamicImageType im_d;
+        (void)load_mapped<DynamicImageType, Internal::CheckFail>(filename, &im_d);
+        Internal::CheckFail(ImageType::can_convert_from(im_d),
+                            "Type mismatch assigning the result of load_mapped_image.");
+        return im_d.template as<typename ImageType::ElemType>();
+    }
+
+private:
+    const std::string filename;
+};
+
+}  // namespace Tools
+}  // namespace Halide
+
+#endif  // HALIDE_IMAGE_IO_MAPPED_H
@@ -0,0 +1,77 @@
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "halide_benchmark.h"
+
+// Compare two sets of benchmark results, as written by the benchmarks in
+// halide_benchmark.h when HL_BENCHMARK_JSON is set (one JSON object per
+// line), and flag the benchmarks that got significantly slower.
+//
+// Usage: HalideBenchmarkCompare baseline.json candidate.json [threshold]
+//
+// A benchmark is a regression if the bootstrap confidence interval for
+// the ratio of median times lies entirely above 1 + threshold (default
+// 0.05), and an improvement if it lies entirely below 1 - threshold.
+// Exits with 1 if there are any regressions.
+
+using namespace Halide::Tools;
+
+namespace {
+
+std::map<std::string, std::vector<double>> load_results(const std::string &filename) {
+    std::map<std::string, std::vector<double>> results;
+    if (!load_benchmark_samples(filename, &results)) {
+        std::cerr << "Unable to open " << filename << "\n";
+        exit(-1);
+    }
+    return results;
+}
+
+}  // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 3) {
+        std::cout << "Usage: HalideBenchmarkCompare baseline.json candidate.json [threshold]\n";
+        return -1;
+    }
+    const double threshold = argc > 3 ? atof(argv[3]) : 0.05;
+    auto baseline = load_results(argv[1]);
+    auto candidate = load_results(argv[2]);
+
+    int regressions = 0;
+    printf("%-40s %12s %12s %8s %19s\n", "benchmark", "baseline", "candidate", "ratio", "95% interval");
+    for (const auto &it : candidate) {
+        auto b = baseline.find(it.first);
+        if (b == baseline.end()) {
+            printf("%-40s %12s %12.6g\n", it.first.c_str(), "-", compute_benchmark_stats(it.second, 1, 0.95, 0).median);
+            continue;
+        }
+        BenchmarkComparison c = compare_benchmark_samples(b->second, it.second);
+        const char *verdict = "";
+        if (c.regression(threshold)) {
+            verdict = "  REGRESSION";
+            regressions++;
+        } else if (c.improvement(threshold)) {
+            verdict = "  improvement";
+        }
+        printf("%-40s %12.6g %12.6g %8.3f [%8.3f, %8.3f]%s\n", it.first.c_str(),
+               compute_benchmark_stats(b->second, 1, 0.95, 0).median,
+               compute_benchmark_stats(it.second, 1, 0.95, 0).median,
+               c.ratio, c.ratio_low, c.ratio_high, verdict);
+    }
+    for (const auto &it : baseline) {
+        if (!candidate.count(it.first)) {
+            printf("%-40s missing from %s\n", it.first.c_str(), argv[2]);
+        }
+    }
+
+    if (regressions) {
+        printf("%d significant regression%s of more than %g%%\n", regressions, regressions > 1 ? "s" : "", threshold * 100);
+        return 1;
+    }
+    return 0;
+}